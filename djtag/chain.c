@@ -0,0 +1,141 @@
+/*
+ * Raspberry Pi RP2040 Control firmware for GMM-7550 module
+ * https://www.gmm7550.dev/doc/rp2040.html
+ *
+ * Copyright (c) 2026 Anton Kuzmin <ak@gmm7550.dev>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "pio_jtag.h"
+#include "tap.h"
+#include "chain.h"
+
+#define DR_SCAN_BITS (32 * (JTAG_CHAIN_MAX_DEVICES + 1))
+
+static jtag_chain_t chain;
+
+/* jtag_chain_invalidate() is called by the tasks switching the board
+ * power or configuration, without the JTAG engine.  It bumps the
+ * generation, the cached chain is valid if it was scanned within the
+ * current one: a scan interrupted by the invalidation is not used. */
+static volatile uint32_t chain_generation = 1;
+static uint32_t chain_scanned; /* generation of the cached chain, 0 -- none */
+
+/* Bit n of the DirtyJTAG-ordered stream (byte by byte, MSB first) */
+static inline bool stream_bit(const uint8_t *buf, uint n)
+{
+  return (buf[n / 8] >> (7 - (n % 8))) & 1;
+}
+
+static uint32_t stream_word(const uint8_t *buf, uint n)
+{
+  uint32_t w = 0;
+  for (int i = 31; i >= 0; i--) {
+    w = (w << 1) | stream_bit(buf, n + i);
+  }
+  return w;
+}
+
+/*
+ * After reset every TAP has IDCODE (LSB is 1) or BYPASS (single 0 bit)
+ * in DR.  Ones are shifted in, so all-ones word marks the end of chain.
+ */
+static void chain_read_idcodes(const pio_jtag_inst_t *jtag)
+{
+  static uint8_t tdi[DR_SCAN_BITS / 8] __aligned(4);
+  static uint8_t tdo[DR_SCAN_BITS / 8 + 1] __aligned(4);
+  uint n = 0;
+
+  memset(tdi, 0xff, sizeof(tdi));
+  tap_goto(jtag, TAP_DRSHIFT);
+  tap_shift_bits(jtag, tdi, tdo, DR_SCAN_BITS, true);
+
+  chain.n_devices = 0;
+  while (n + 32 <= DR_SCAN_BITS && chain.n_devices < JTAG_CHAIN_MAX_DEVICES) {
+    if (stream_bit(tdo, n)) {
+      uint32_t id = stream_word(tdo, n);
+      if (id == 0xffffffff) break;
+      chain.idcode[chain.n_devices++] = id;
+      n += 32;
+    } else {
+      chain.idcode[chain.n_devices++] = 0;
+      n += 1;
+    }
+  }
+  /* TDO stuck at zero looks like a chain of BYPASS devices */
+  if (stream_word(tdo, 0) == 0 && stream_word(tdo, 32) == 0) chain.n_devices = 0;
+}
+
+/*
+ * Fill all IRs with ones, then shift zeros and count ones on TDO.
+ * The IRs are filled with ones (BYPASS) again before Update-IR.
+ * IR capture value of every TAP ends with 01 (LSB first: 1, 0), this
+ * is used to split the total length if the number of such patterns
+ * matches the number of devices.
+ */
+static void chain_read_ir(const pio_jtag_inst_t *jtag)
+{
+  static uint8_t ones[JTAG_CHAIN_MAX_IR / 8] __aligned(4);
+  static uint8_t zeros[JTAG_CHAIN_MAX_IR / 8] __aligned(4);
+  static uint8_t capture[JTAG_CHAIN_MAX_IR / 8 + 1] __aligned(4);
+  static uint8_t tdo[JTAG_CHAIN_MAX_IR / 8 + 1] __aligned(4);
+  uint start[JTAG_CHAIN_MAX_DEVICES + 1];
+  uint n_start = 0;
+  uint len = 0;
+
+  memset(ones, 0xff, sizeof(ones));
+  memset(zeros, 0, sizeof(zeros));
+  tap_goto(jtag, TAP_IRSHIFT);
+  tap_shift_bits(jtag, ones, capture, JTAG_CHAIN_MAX_IR, false);
+  tap_shift_bits(jtag, zeros, tdo, JTAG_CHAIN_MAX_IR, false);
+  tap_shift_bits(jtag, ones, NULL, JTAG_CHAIN_MAX_IR, true);
+  tap_goto(jtag, TAP_IDLE);
+
+  while (len < JTAG_CHAIN_MAX_IR && stream_bit(tdo, len)) len++;
+  chain.ir_total = (len < JTAG_CHAIN_MAX_IR) ? len : 0;
+
+  memset(chain.ir_len, 0, sizeof(chain.ir_len));
+  if (chain.n_devices == 1) {
+    chain.ir_len[0] = chain.ir_total;
+    return;
+  }
+  for (uint i = 0; i + 1 < chain.ir_total; i++) {
+    if (stream_bit(capture, i) && !stream_bit(capture, i + 1)) {
+      if (n_start == JTAG_CHAIN_MAX_DEVICES) return;
+      start[n_start++] = i;
+    }
+  }
+  if (n_start != chain.n_devices || (n_start && start[0] != 0)) return;
+  start[n_start] = chain.ir_total;
+  for (uint d = 0; d < n_start; d++) {
+    chain.ir_len[d] = start[d + 1] - start[d];
+  }
+}
+
+const jtag_chain_t *jtag_chain_scan(const pio_jtag_inst_t *jtag)
+{
+  uint32_t generation = chain_generation;
+
+  chain_scanned = 0;
+  memset(&chain, 0, sizeof(chain));
+  tap_reset(jtag);
+  chain_read_idcodes(jtag);
+  if (chain.n_devices) chain_read_ir(jtag);
+  tap_reset(jtag);
+  chain_scanned = generation;
+  return &chain;
+}
+
+const jtag_chain_t *jtag_chain_get(const pio_jtag_inst_t *jtag)
+{
+  return (chain_scanned == chain_generation) ? &chain : jtag_chain_scan(jtag);
+}
+
+void jtag_chain_invalidate(void)
+{
+  chain_generation++;
+}
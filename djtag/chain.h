@@ -0,0 +1,40 @@
+/*
+ * Raspberry Pi RP2040 Control firmware for GMM-7550 module
+ * https://www.gmm7550.dev/doc/rp2040.html
+ *
+ * Copyright (c) 2026 Anton Kuzmin <ak@gmm7550.dev>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* JTAG scan chain discovery with a cached result */
+
+#ifndef _CHAIN_H
+#define _CHAIN_H
+
+#include "pio_jtag.h"
+
+#define JTAG_CHAIN_MAX_DEVICES 8
+#define JTAG_CHAIN_MAX_IR      256 /* total IR length, bits */
+
+typedef struct jtag_chain {
+  uint8_t n_devices;
+  uint16_t ir_total;
+  /* Devices are listed from TDO side of the chain */
+  uint32_t idcode[JTAG_CHAIN_MAX_DEVICES]; /* 0 -- device is in BYPASS after reset */
+  uint8_t ir_len[JTAG_CHAIN_MAX_DEVICES];  /* 0 -- unknown */
+} jtag_chain_t;
+
+/*
+ * Reset TAPs, read IDCODEs and IR lengths.  TAPs are left in
+ * Test-Logic-Reset state.  The result is cached.
+ */
+const jtag_chain_t *jtag_chain_scan(const pio_jtag_inst_t *jtag);
+
+/* Cached result, the chain is scanned if it was not yet */
+const jtag_chain_t *jtag_chain_get(const pio_jtag_inst_t *jtag);
+
+/* Drop the cached result, may be called without the JTAG engine */
+void jtag_chain_invalidate(void);
+
+#endif
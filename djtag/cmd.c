@@ -32,6 +32,9 @@
 #include "jtag.pio.h"
 #include "tusb.h"
 #include "pio_jtag.h"
+#include "tap.h"
+#include "chain.h"
+#include "trace.h"
 #include "cmd.h"
 
 
@@ -44,7 +47,12 @@ enum CommandIdentifier {
   CMD_GETSIG = 0x05,
   CMD_CLK = 0x06,
   CMD_SETVOLTAGE = 0x07,
-  CMD_GOTOBOOTLOADER = 0x08
+  CMD_GOTOBOOTLOADER = 0x08,
+  CMD_XFER_LONG = 0x09,
+  CMD_TAP_GOTO = 0x0A,
+  CMD_TAP_SHIFT = 0x0B,
+  CMD_TAP_RUN = 0x0C,
+  CMD_EDGES = 0x0D
 };
 
 enum CommandModifier
@@ -52,10 +60,87 @@ enum CommandModifier
   // CMD_XFER
   NO_READ = 0x80,
   EXTEND_LENGTH = 0x40,
-  // CMD_CLK
+  // CMD_CLK, CMD_FREQ, CMD_EDGES
   READOUT = 0x80,
+  // CMD_INFO
+  CAPABILITIES = 0x80,
+  CHAIN = 0x40,
+  // CMD_TAP_SHIFT (and NO_READ)
+  SHIFT_IR = 0x40,
+  // CMD_XFER_LONG (and NO_READ)
+  VERIFY = 0x20,
 };
 
+/*
+ * Protocol extensions, reported by CMD_INFO|CAPABILITIES as a
+ * little-endian 32-bit capability mask followed by the maximum
+ * CMD_XFER_LONG length in bits (also 32-bit little-endian).
+ *
+ * CMD_XFER_LONG[|NO_READ] len0 len1 len2 len3 <TDI data>
+ *   Shift up to 2^30 bits (little-endian length, a longer one halts
+ *   the packet as an unsupported command does).  TDI data follows
+ *   the header in the same packet and continues in the next packets;
+ *   once all (len+7)/8 data bytes are consumed, the rest of the packet
+ *   is parsed as commands again.  TDO data is returned per packet, as
+ *   soon as the corresponding chunk has been shifted.  The probe is not
+ *   shared with other JTAG users until the shift is complete; a shift
+ *   still waiting for data is abandoned on USB bus reset, or when no
+ *   data come for a while (see jtag.c).
+ *
+ * CMD_XFER_LONG|VERIFY len0 len1 len2 len3 mask <TDI, expected TDO>...
+ *   Same shift, but each data byte comes as two bytes: TDI and expected
+ *   TDO, i.e. 2*(len+7)/8 bytes follow the header.  The compare mask is
+ *   given once and applies to every byte (0xff -- compare all bits);
+ *   scans that need a per-bit mask read TDO back with CMD_XFER_LONG.
+ *   TDO is compared on the probe and no TDO data is returned.  After the
+ *   last chunk a 5-byte status is returned: 0 -- match, 1 -- mismatch,
+ *   followed by the offset of the first failing bit (32-bit
+ *   little-endian, 0xffffffff on match).
+ *
+ * Firmware tracks TAP state, including the state changes made by
+ * CMD_XFER, CMD_CLK and CMD_SETSIG.  TAP states are numbered as
+ * tap_state_t in tap.h (0 -- Test-Logic-Reset, 1 -- Run-Test/Idle, ...)
+ *
+ * CMD_TAP_GOTO state
+ *   Move TAP to the state by the shortest TMS path.
+ * CMD_TAP_SHIFT[|SHIFT_IR][|NO_READ] len0 len1 end_state <TDI data>
+ *   Go to Shift-DR (Shift-IR), shift len bits (little-endian, up to
+ *   TAP_SHIFT_MAX_BITS), raising TMS on the last bit, then go to
+ *   end_state.  TDI data follows in the same packet, TDO data
+ *   (len+7)/8 bytes is returned unless NO_READ is set.
+ * CMD_TAP_RUN n0 n1 n2 n3
+ *   Go to Run-Test/Idle and clock n cycles (little-endian) there.
+ *
+ * CMD_FREQ|READOUT f1 f0
+ *   Same as CMD_FREQ, returns the actual TCK frequency in Hz
+ *   (32-bit little-endian).
+ *
+ * CMD_EDGES[|READOUT] n <n states>
+ *   Bit-bang up to EDGES_MAX_STATES pin states, each one is a SIG_TCK,
+ *   SIG_TDI and SIG_TMS combination and lasts half TCK period.  TDO is
+ *   sampled on rising TCK; with READOUT (n+7)/8 bytes are returned, bit
+ *   i (LSB first) is the TDO value sampled up to state i.
+ *
+ * CMD_INFO|CHAIN
+ *   Returns the cached scan chain (see chain.h), the chain is scanned
+ *   on the first request: number of devices, then JTAG_CHAIN_MAX_DEVICES
+ *   entries of IDCODE (32-bit little-endian) and IR length (1 byte).
+ */
+enum Capability {
+  CAP_XFER_LONG = 1 << 0,
+  CAP_TAP = 1 << 1,
+  CAP_FREQ_READOUT = 1 << 2,
+  CAP_CHAIN = 1 << 3,
+  CAP_VERIFY = 1 << 4,
+  CAP_EDGES = 1 << 5,
+};
+
+#define TAP_SHIFT_MAX_BITS ((64 - 4) * 8)
+
+#define XFER_LONG_MAX_BITS (1u << 30)
+
+#define EDGES_MAX_STATES (64 - 2)
+
 enum SignalIdentifier {
   SIG_TCK = 1 << 1,
   SIG_TDI = 1 << 2,
@@ -76,15 +161,36 @@ enum SignalIdentifier {
  */
 static uint32_t  cmd_info(uint8_t *buffer);
 
+/**
+ * @brief Handle CMD_INFO|CAPABILITIES command
+ *
+ * Returns the mask of supported protocol extensions and
+ * the maximum length of CMD_XFER_LONG shift.
+ *
+ * @param buffer Response buffer
+ */
+static uint32_t cmd_capabilities(uint8_t *buffer);
+
+/**
+ * @brief Handle CMD_INFO|CHAIN command
+ *
+ * Returns the cached scan chain, scanning it if needed.
+ *
+ * @param buffer Response buffer
+ */
+static uint32_t cmd_chain(pio_jtag_inst_t* jtag, uint8_t *buffer);
+
 /**
  * @brief Handle CMD_FREQ command
  *
  * CMD_FREQ sets the clock frequency on the probe.
- * Currently this does not changes anything.
+ * With READOUT modifier the actual TCK frequency is returned.
  *
  * @param commands Command data
+ * @param readout Return actual frequency
+ * @param buffer Response buffer
  */
-static void cmd_freq(pio_jtag_inst_t* jtag, const uint8_t *commands);
+static uint32_t cmd_freq(pio_jtag_inst_t* jtag, const uint8_t *commands, bool readout, uint8_t *buffer);
 
 /**
  * @brief Handle CMD_XFER command
@@ -96,6 +202,65 @@ static void cmd_freq(pio_jtag_inst_t* jtag, const uint8_t *commands);
  */
 static uint32_t cmd_xfer(pio_jtag_inst_t* jtag, const uint8_t *commands, bool extend_length, bool no_read, uint8_t* tx_buf);
 
+/**
+ * @brief Handle CMD_XFER_LONG command header
+ *
+ * CMD_XFER_LONG starts a shift, which TDI data may span
+ * several USB packets.
+ *
+ * @param commands Command data
+ * @param no_read Do not return TDO data
+ */
+static uint32_t cmd_xfer_long(pio_jtag_inst_t* jtag, const uint8_t *commands, bool no_read, bool verify);
+
+/**
+ * @brief Shift next chunk of CMD_XFER_LONG data
+ *
+ * @param data TDI data
+ * @param count Number of data bytes available in the packet
+ * @param tx_buf TDO data buffer
+ * @param reply Number of bytes put into tx_buf
+ * @return Number of data bytes consumed
+ */
+static uint32_t cmd_xfer_long_data(pio_jtag_inst_t* jtag, const uint8_t *data, uint32_t count, uint8_t* tx_buf, uint32_t *reply);
+
+/**
+ * @brief Shift and verify next chunk of CMD_XFER_LONG|VERIFY data
+ *
+ * @param data TDI and expected TDO pairs
+ * @param count Number of data bytes available in the packet
+ * @param tx_buf Status buffer
+ * @return Number of status bytes (after the last chunk)
+ */
+static uint32_t cmd_xfer_long_verify(pio_jtag_inst_t* jtag, const uint8_t *data, uint32_t count, uint8_t* tx_buf);
+
+/**
+ * @brief Handle CMD_TAP_GOTO command
+ *
+ * @param commands Command data
+ */
+static void cmd_tap_goto(pio_jtag_inst_t* jtag, const uint8_t *commands);
+
+/**
+ * @brief Handle CMD_TAP_SHIFT command
+ *
+ * CMD_TAP_SHIFT performs a complete IR or DR scan.
+ *
+ * @param commands Command data
+ * @param ir Shift instruction register
+ * @param no_read Do not return TDO data
+ * @param tx_buf TDO data buffer
+ * @return Number of TDI data bytes
+ */
+static uint32_t cmd_tap_shift(pio_jtag_inst_t* jtag, const uint8_t *commands, bool ir, bool no_read, uint8_t* tx_buf);
+
+/**
+ * @brief Handle CMD_TAP_RUN command
+ *
+ * @param commands Command data
+ */
+static void cmd_tap_run(pio_jtag_inst_t* jtag, const uint8_t *commands);
+
 /**
  * @brief Handle CMD_SETSIG command
  *
@@ -124,6 +289,19 @@ static uint32_t cmd_getsig(pio_jtag_inst_t* jtag, uint8_t *buffer);
  * @param readout Enable TDO readout
  */
 static uint32_t cmd_clk(pio_jtag_inst_t *jtag, const uint8_t *commands, bool readout, uint8_t *buffer);
+
+/**
+ * @brief Handle CMD_EDGES command
+ *
+ * CMD_EDGES drives a sequence of TCK, TDI and TMS states directly.
+ *
+ * @param commands Command data
+ * @param readout Enable TDO readout
+ * @param buffer TDO data buffer
+ * @return Number of state bytes
+ */
+static uint32_t cmd_edges(pio_jtag_inst_t *jtag, const uint8_t *commands, bool readout, uint8_t *buffer);
+
 /**
  * @brief Handle CMD_SETVOLTAGE command
  *
@@ -140,22 +318,79 @@ static void cmd_setvoltage(const uint8_t *commands);
  */
 static void cmd_gotobootloader(void);
 
-void cmd_handle(pio_jtag_inst_t* jtag, uint8_t* rxbuf, uint32_t count, uint8_t* tx_buf) {
+/* State of CMD_XFER_LONG shift spanning several packets */
+static struct {
+  uint32_t bytes_remaining;
+  bool no_read;
+  bool verify;
+  uint32_t bits;          /* total length */
+  uint32_t bytes_done;    /* TDO bytes verified so far */
+  uint32_t fail_offset;   /* first failing bit */
+  uint8_t mask;           /* compare mask of every byte */
+  uint8_t pair[2];        /* TDI, expected split across packets */
+  uint8_t pair_len;
+} xfer_long;
+
+#define VERIFY_OK 0xffffffff
+
+_Static_assert((XFER_LONG_MAX_BITS + 7ull) / 8 * 2 <= UINT32_MAX, "CMD_XFER_LONG|VERIFY byte count");
+
+/* Number of bits shifted or clocked by the command, for the trace */
+static inline uint32_t cmd_bits(const uint8_t *commands) {
+  switch ((*commands)&0x0F) {
+  case CMD_XFER:
+    return commands[1] + ((*commands & EXTEND_LENGTH) ? 256 : 0);
+  case CMD_CLK:
+    return commands[2];
+  case CMD_EDGES:
+    return commands[1];
+  case CMD_TAP_SHIFT:
+    return commands[1] | (commands[2] << 8);
+  case CMD_XFER_LONG:
+  case CMD_TAP_RUN:
+    return commands[1] | (commands[2] << 8) | (commands[3] << 16) | ((uint32_t)commands[4] << 24);
+  default:
+    return 0;
+  }
+}
+
+uint32_t cmd_handle(pio_jtag_inst_t* jtag, uint8_t* rxbuf, uint32_t count, uint8_t* tx_buf) {
   uint8_t *commands= (uint8_t*)rxbuf;
   uint8_t *output_buffer = tx_buf;
-  while ((commands < (rxbuf + count)) && (*commands != CMD_STOP))
+  while (commands < (rxbuf + count))
   {
+    if (xfer_long.bytes_remaining)
+    {
+      uint32_t reply, consumed;
+      bool verify = xfer_long.verify;
+      trace_cmd_start(TRACE_OP_DATA);
+      consumed = cmd_xfer_long_data(jtag, commands, (rxbuf + count) - commands, output_buffer, &reply);
+      trace_cmd_done(verify ? consumed * 4 : consumed * 8);
+      commands += consumed;
+      output_buffer += reply;
+      continue;
+    }
+    if (*commands == CMD_STOP)
+      break;
+
+    uint32_t bits = cmd_bits(commands);
+    trace_cmd_start(*commands);
+
     switch ((*commands)&0x0F) {
     case CMD_INFO:
     {
-      uint32_t trbytes = cmd_info(output_buffer);
+      uint32_t trbytes = (*commands & CAPABILITIES) ? cmd_capabilities(output_buffer) :
+                         (*commands & CHAIN) ? cmd_chain(jtag, output_buffer) : cmd_info(output_buffer);
       output_buffer += trbytes;
       break;
     }
     case CMD_FREQ:
-      cmd_freq(jtag, commands);
+    {
+      uint32_t trbytes = cmd_freq(jtag, commands, !!(*commands & READOUT), output_buffer);
+      output_buffer += trbytes;
       commands += 2;
       break;
+    }
 
     case CMD_XFER:
     {
@@ -183,6 +418,13 @@ void cmd_handle(pio_jtag_inst_t* jtag, uint8_t* rxbuf, uint32_t count, uint8_t*
       commands += 2;
       break;
     }
+    case CMD_EDGES:
+    {
+      uint32_t n = cmd_edges(jtag, commands, !!(*commands & READOUT), output_buffer);
+      output_buffer += (*commands & READOUT) ? (n + 7) / 8 : 0;
+      commands += 1 + n;
+      break;
+    }
     case CMD_SETVOLTAGE:
       cmd_setvoltage(commands);
       commands += 1;
@@ -191,21 +433,56 @@ void cmd_handle(pio_jtag_inst_t* jtag, uint8_t* rxbuf, uint32_t count, uint8_t*
     case CMD_GOTOBOOTLOADER:
       cmd_gotobootloader();
       break;
+
+    case CMD_XFER_LONG:
+      if (bits > XFER_LONG_MAX_BITS) {
+        trace_cmd_done(0);
+        return output_buffer - tx_buf; /* Longer than advertised, halt */
+      }
+      commands += cmd_xfer_long(jtag, commands, *commands & NO_READ, *commands & VERIFY);
+      break;
+
+    case CMD_TAP_GOTO:
+      cmd_tap_goto(jtag, commands);
+      commands += 1;
+      break;
+
+    case CMD_TAP_SHIFT:
+    {
+      bool no_read = *commands & NO_READ;
+      uint32_t trbytes = cmd_tap_shift(jtag, commands, *commands & SHIFT_IR, no_read, output_buffer);
+      commands += 3 + trbytes;
+      output_buffer += (no_read ? 0 : trbytes);
+      break;
+    }
+    case CMD_TAP_RUN:
+      cmd_tap_run(jtag, commands);
+      commands += 4;
+      break;
       
     default:
-      return; /* Unsupported command, halt */
+      trace_cmd_done(0);
+      return output_buffer - tx_buf; /* Unsupported command, halt */
       break;
     }
 
+    trace_cmd_done(bits);
     commands++;
   }
-  /* Send the transfer response back to host */
-  if (tx_buf != output_buffer)
+  /* The transfer response is sent back to host by the caller */
+  return output_buffer - tx_buf;
+}
+
+bool cmd_stream_open(void) {
+  return xfer_long.bytes_remaining != 0;
+}
+
+void cmd_reset(pio_jtag_inst_t* jtag) {
+  if (xfer_long.bytes_remaining)
   {
-    tud_vendor_write(tx_buf, output_buffer - tx_buf);
-    tud_vendor_flush();
+    pio_jtag_stream_abort(jtag);
   }
-  return;
+  memset(&xfer_long, 0, sizeof(xfer_long));
 }
 
 static uint32_t cmd_info(uint8_t *buffer) {
@@ -214,8 +491,43 @@ static uint32_t cmd_info(uint8_t *buffer) {
   return 10;
 }
 
-static void cmd_freq(pio_jtag_inst_t* jtag, const uint8_t *commands) {
-  jtag_set_clk_freq(jtag, (commands[1] << 8) | commands[2]);
+static uint32_t cmd_capabilities(uint8_t *buffer) {
+  const uint32_t caps = CAP_XFER_LONG | CAP_TAP | CAP_FREQ_READOUT | CAP_CHAIN | CAP_VERIFY | CAP_EDGES;
+  const uint32_t max_bits = XFER_LONG_MAX_BITS;
+  for (int i = 0; i < 4; i++) {
+    buffer[i]     = (caps     >> (8 * i)) & 0xff;
+    buffer[4 + i] = (max_bits >> (8 * i)) & 0xff;
+  }
+  return 8;
+}
+
+_Static_assert(CMD_MAX_REPLY >= 1 + JTAG_CHAIN_MAX_DEVICES * 5, "CMD_INFO|CHAIN reply size");
+
+static uint32_t cmd_chain(pio_jtag_inst_t* jtag, uint8_t *buffer) {
+  const jtag_chain_t *chain = jtag_chain_get(jtag);
+  uint8_t *p = buffer;
+
+  *p++ = chain->n_devices;
+  for (int d = 0; d < JTAG_CHAIN_MAX_DEVICES; d++) {
+    uint32_t id = (d < chain->n_devices) ? chain->idcode[d] : 0;
+    for (int i = 0; i < 4; i++) {
+      *p++ = (id >> (8 * i)) & 0xff;
+    }
+    *p++ = (d < chain->n_devices) ? chain->ir_len[d] : 0;
+  }
+  return p - buffer;
+}
+
+static uint32_t cmd_freq(pio_jtag_inst_t* jtag, const uint8_t *commands, bool readout, uint8_t *buffer) {
+  uint32_t freq_hz = jtag_set_clk_freq(jtag, (commands[1] << 8) | commands[2]);
+
+  if (readout)
+  {
+    for (int i = 0; i < 4; i++) {
+      buffer[i] = (freq_hz >> (8 * i)) & 0xff;
+    }
+  }
+  return readout ? 4 : 0;
 }
 
 //static uint8_t output_buffer[64];
@@ -242,20 +554,122 @@ static uint32_t cmd_xfer(pio_jtag_inst_t* jtag, const uint8_t *commands, bool ex
   }
 
   jtag_transfer(jtag, transferred_bits, commands+2, output_buffer);
+  tap_clocked(false, transferred_bits);
 
   return (transferred_bits + 7) / 8;
 }
 
+static uint32_t cmd_xfer_long(pio_jtag_inst_t* jtag, const uint8_t *commands, bool no_read, bool verify) {
+  uint32_t transferred_bits = commands[1] |
+    (commands[2] << 8) | (commands[3] << 16) | ((uint32_t)commands[4] << 24);
+
+  if (transferred_bits != 0)
+  {
+    xfer_long.bytes_remaining = (transferred_bits + 7) / 8 * (verify ? 2 : 1);
+    xfer_long.no_read = no_read;
+    xfer_long.verify = verify;
+    xfer_long.bits = transferred_bits;
+    xfer_long.bytes_done = 0;
+    xfer_long.fail_offset = VERIFY_OK;
+    xfer_long.mask = verify ? commands[5] : 0xff;
+    xfer_long.pair_len = 0;
+    pio_jtag_stream_start(jtag, transferred_bits);
+    tap_clocked(false, transferred_bits);
+  }
+  return verify ? 5 : 4;
+}
+
+static uint32_t cmd_xfer_long_data(pio_jtag_inst_t* jtag, const uint8_t *data, uint32_t count, uint8_t* tx_buf, uint32_t *reply) {
+  uint32_t trbytes = (count < xfer_long.bytes_remaining) ? count : xfer_long.bytes_remaining;
+
+  if (xfer_long.verify) {
+    *reply = cmd_xfer_long_verify(jtag, data, trbytes, tx_buf);
+    return trbytes;
+  }
+  xfer_long.bytes_remaining -= trbytes;
+  pio_jtag_stream_write_read(jtag, data, xfer_long.no_read ? NULL : tx_buf, trbytes);
+  *reply = xfer_long.no_read ? 0 : trbytes;
+  return trbytes;
+}
+
+static uint32_t cmd_xfer_long_verify(pio_jtag_inst_t* jtag, const uint8_t *data, uint32_t count, uint8_t* tx_buf) {
+  /* a packet holds up to 64/2 pairs (one may be completed from the previous packet) */
+  uint8_t tdi[64 / 2], expected[64 / 2];
+  uint8_t tdo[64 / 2];
+  uint32_t n = 0;
+
+  xfer_long.bytes_remaining -= count;
+  while (count--) {
+    xfer_long.pair[xfer_long.pair_len++] = *data++;
+    if (xfer_long.pair_len == 2) {
+      tdi[n] = xfer_long.pair[0];
+      expected[n] = xfer_long.pair[1];
+      xfer_long.pair_len = 0;
+      n++;
+    }
+  }
+  if (n == 0)
+    return 0;
+
+  pio_jtag_stream_write_read(jtag, tdi, tdo, n);
+  for (uint32_t i = 0; i < n && xfer_long.fail_offset == VERIFY_OK; i++) {
+    uint32_t bit = (xfer_long.bytes_done + i) * 8;
+    uint8_t diff = (tdo[i] ^ expected[i]) & xfer_long.mask;
+    if (xfer_long.bits - bit < 8) {
+      diff &= 0xff << (8 - (xfer_long.bits - bit)); /* unused bits of the last byte */
+    }
+    if (diff) {
+      xfer_long.fail_offset = bit + __builtin_clz(diff) - 24; /* MSB is the first bit */
+    }
+  }
+  xfer_long.bytes_done += n;
+  if (xfer_long.bytes_remaining)
+    return 0;
+
+  tx_buf[0] = (xfer_long.fail_offset != VERIFY_OK);
+  for (int i = 0; i < 4; i++) {
+    tx_buf[1 + i] = (xfer_long.fail_offset >> (8 * i)) & 0xff;
+  }
+  return 5;
+}
+
+static void cmd_tap_goto(pio_jtag_inst_t* jtag, const uint8_t *commands) {
+  if (commands[1] < TAP_N_STATES)
+  {
+    tap_goto(jtag, commands[1]);
+  }
+}
+
+static uint32_t cmd_tap_shift(pio_jtag_inst_t* jtag, const uint8_t *commands, bool ir, bool no_read, uint8_t* tx_buf) {
+  uint32_t transferred_bits = commands[1] | (commands[2] << 8);
+  tap_state_t end_state = (commands[3] < TAP_N_STATES) ? commands[3] : TAP_IDLE;
+
+  // Ensure we don't do over-read
+  if (transferred_bits > TAP_SHIFT_MAX_BITS)
+  {
+    transferred_bits = TAP_SHIFT_MAX_BITS;
+  }
+
+  tap_shift(jtag, ir, commands + 4, no_read ? NULL : tx_buf, transferred_bits, end_state);
+
+  return (transferred_bits + 7) / 8;
+}
+
+static void cmd_tap_run(pio_jtag_inst_t* jtag, const uint8_t *commands) {
+  uint32_t cycles = commands[1] |
+    (commands[2] << 8) | (commands[3] << 16) | ((uint32_t)commands[4] << 24);
+
+  tap_goto(jtag, TAP_IDLE);
+  tap_run(jtag, cycles);
+}
+
 static void cmd_setsig(pio_jtag_inst_t* jtag, const uint8_t *commands) {
   uint8_t signal_mask, signal_status;
 
   signal_mask = commands[1];
   signal_status = commands[2];
 
-  if (signal_mask & SIG_TCK) {
-    jtag_set_clk(jtag,signal_status & SIG_TCK);
-  }
-
+  /* TDI and TMS are set up before the rising TCK edge */
   if (signal_mask & SIG_TDI) {
     jtag_set_tdi(jtag, signal_status & SIG_TDI);
   }
@@ -263,6 +677,13 @@ static void cmd_setsig(pio_jtag_inst_t* jtag, const uint8_t *commands) {
   if (signal_mask & SIG_TMS) {
     jtag_set_tms(jtag, signal_status & SIG_TMS);
   }
+
+  if (signal_mask & SIG_TCK) {
+    if ((signal_status & SIG_TCK) && !jtag_get_clk(jtag)) {
+      tap_clocked(gpio_get(jtag->pin_tms), 1);
+    }
+    jtag_set_clk(jtag, signal_status & SIG_TCK);
+  }
   
   if (signal_mask & SIG_TRST) {
     jtag_set_trst(jtag, signal_status & SIG_TRST);
@@ -290,6 +711,7 @@ static uint32_t cmd_clk(pio_jtag_inst_t *jtag, const uint8_t *commands, bool rea
   signals = commands[1];
   clk_pulses = commands[2];
   uint8_t readout_val = jtag_strobe(jtag, clk_pulses, signals & SIG_TMS, signals & SIG_TDI);
+  tap_clocked(signals & SIG_TMS, clk_pulses);
 
   if (readout)
   {
@@ -298,6 +720,30 @@ static uint32_t cmd_clk(pio_jtag_inst_t *jtag, const uint8_t *commands, bool rea
   return readout ? 1 : 0;
 }
 
+static uint32_t cmd_edges(pio_jtag_inst_t *jtag, const uint8_t *commands, bool readout, uint8_t *buffer)
+{
+  uint8_t states[EDGES_MAX_STATES];
+  uint32_t n = MIN(commands[1], EDGES_MAX_STATES);
+  bool tck = jtag_get_clk(jtag);
+
+  for (uint32_t i = 0; i < n; i++) {
+    uint8_t s = commands[2 + i];
+    states[i] = ((s & SIG_TCK) ? JTAG_SIO_TCK : 0) |
+                ((s & SIG_TDI) ? JTAG_SIO_TDI : 0) |
+                ((s & SIG_TMS) ? JTAG_SIO_TMS : 0);
+    if ((s & SIG_TCK) && !tck) {
+      tap_clocked(s & SIG_TMS, 1);
+    }
+    tck = s & SIG_TCK;
+  }
+
+  if (readout) {
+    memset(buffer, 0, (n + 7) / 8);
+  }
+  jtag_sio_sequence(jtag, states, n, readout ? buffer : NULL);
+  return n;
+}
+
 static void cmd_setvoltage(const uint8_t *commands) {
   (void)commands;
 }
@@ -20,11 +20,33 @@
  * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
+/* Longest reply to a single command byte (CMD_INFO|CHAIN) */
+#define CMD_MAX_REPLY (1 + 8 * 5)
+
 /**
  * @brief Handle a DirtyJTAG command
  *
- * @param usbd_dev USB device
- * @param transfer Received packet
- * @return Command needs to send data back to host
+ * @param jtag JTAG engine
+ * @param rxbuf Received packet
+ * @param count Received packet length
+ * @param tx_buf Response buffer, CMD_MAX_REPLY bytes per command byte
+ * @return Number of response bytes to send back to host
+ */
+uint32_t cmd_handle(pio_jtag_inst_t* jtag, uint8_t* rxbuf, uint32_t count, uint8_t* tx_buf);
+
+/**
+ * @brief Check for CMD_XFER_LONG shift waiting for data
+ *
+ * @return True if the shift continues in the next packets
+ */
+bool cmd_stream_open(void);
+
+/**
+ * @brief Abandon CMD_XFER_LONG shift waiting for data, if any
+ *
+ * The rest of its data is not expected any more and the JTAG
+ * state machine is ready for the next transfer.
+ *
+ * @param jtag JTAG engine
  */
-void cmd_handle(pio_jtag_inst_t* jtag, uint8_t* rxbuf, uint32_t count, uint8_t* tx_buf);
+void cmd_reset(pio_jtag_inst_t* jtag);
@@ -23,6 +23,8 @@
  *
  */
 
+#include <assert.h>
+#include <string.h>
 #include <hardware/clocks.h>
 #include "hardware/dma.h"
 #include "gmm7550_control.h"
@@ -32,12 +34,94 @@
 // void jtag_task();//to process USB OUT packets while waiting for DMA to finish
 
 static bool last_tdo = false;
+// TMS level driven by the PIO program between the transfers
+static bool tms_level = false;
 
 static int tx_dma_chan = -1;
 static int rx_dma_chan;
 static dma_channel_config tx_c;
 static dma_channel_config rx_c;
 
+// Current autopull/autopush threshold, bits per FIFO word
+static uint fifo_width = 8;
+
+// TCK, TDI and TMS are driven by SIO for bit-banged operations (CMD_SETSIG,
+// short strobes), the pins are given back to the PIO on the next transfer.
+// Pin levels are kept on both handovers, TCK is low when the PIO owns it.
+static bool sio_owned = false;
+// Half TCK period in clk_sys cycles, bit-banged TCK is not above the set frequency
+static uint32_t sio_half_cycles = 31 * 2;
+
+static inline uint32_t sio_pin_mask(const pio_jtag_inst_t *jtag)
+{
+    return (1u << jtag->pin_tck) | (1u << jtag->pin_tdi) | (1u << jtag->pin_tms);
+}
+
+static void jtag_sio_acquire(const pio_jtag_inst_t *jtag)
+{
+    const uint32_t txstall = 1u << (PIO_FDEBUG_TXSTALL_LSB + jtag->sm);
+    const uint32_t mask = sio_pin_mask(jtag);
+
+    if (sio_owned)
+        return;
+    // the state machine may still be lowering TCK after the last transfer,
+    // wait for it to stall on the header pull
+    jtag->pio->fdebug = txstall;
+    while (!pio_sm_is_tx_fifo_empty(jtag->pio, jtag->sm) || !(jtag->pio->fdebug & txstall))
+        tight_loop_contents();
+    gpio_put_masked(mask, gpio_get_all() & mask);
+    gpio_set_dir_out_masked(mask);
+    gpio_set_function(jtag->pin_tck, GPIO_FUNC_SIO);
+    gpio_set_function(jtag->pin_tdi, GPIO_FUNC_SIO);
+    gpio_set_function(jtag->pin_tms, GPIO_FUNC_SIO);
+    sio_owned = true;
+}
+
+static void jtag_sio_release(const pio_jtag_inst_t *jtag)
+{
+    const uint32_t mask = sio_pin_mask(jtag);
+
+    // the state machine is stalled on pull, TCK goes low here if it was left high
+    pio_sm_set_pins_with_mask(jtag->pio, jtag->sm, gpio_get_all() & mask & ~(1u << jtag->pin_tck), mask);
+    pio_gpio_init(jtag->pio, jtag->pin_tdi);
+    pio_gpio_init(jtag->pio, jtag->pin_tms);
+    pio_gpio_init(jtag->pio, jtag->pin_tck);
+    sio_owned = false;
+}
+
+// Start a transfer: set FIFO word width and send the header (see jtag.pio).
+// The state machine waits for the header between the transfers, so the
+// shift thresholds may be changed here.
+static inline void pio_jtag_start(const pio_jtag_inst_t *jtag, size_t len, bool tms, bool tms_last, uint width)
+{
+    assert(len >= 1 && len <= PIO_JTAG_MAX_BITS);
+    if (sio_owned)
+        jtag_sio_release(jtag);
+    if (width != fifo_width)
+    {
+        uint thresh = width & 0x1f; // 32 is encoded as 0
+        hw_write_masked(&jtag->pio->sm[jtag->sm].shiftctrl,
+                        (thresh << PIO_SM0_SHIFTCTRL_PULL_THRESH_LSB) |
+                        (thresh << PIO_SM0_SHIFTCTRL_PUSH_THRESH_LSB),
+                        PIO_SM0_SHIFTCTRL_PULL_THRESH_BITS | PIO_SM0_SHIFTCTRL_PUSH_THRESH_BITS);
+        fifo_width = width;
+    }
+    tms_level = tms_last;
+    pio_sm_put(jtag->pio, jtag->sm, ((uint32_t)tms << 31) | ((uint32_t)tms_last << 30) | (len - 1));
+}
+
+// 8-bit FIFO words: TDI byte is shifted out from the top of the OSR (shift left),
+// TDO byte is pushed from the bottom of the ISR
+static inline void pio_jtag_put8(const pio_jtag_inst_t *jtag, uint8_t b)
+{
+    pio_sm_put(jtag->pio, jtag->sm, (uint32_t)b << 24);
+}
+
+static inline uint8_t pio_jtag_get8(const pio_jtag_inst_t *jtag)
+{
+    return (uint8_t)pio_sm_get(jtag->pio, jtag->sm);
+}
+
 static void dma_init()
 {
     if (tx_dma_chan == -1)
@@ -76,99 +160,168 @@ static void dma_init()
     }
 }
 
+static void dma_set_size(enum dma_channel_transfer_size size)
+{
+    channel_config_set_transfer_data_size(&tx_c, size);
+    channel_config_set_transfer_data_size(&rx_c, size);
+    // 32-bit FIFO words are shifted MSB first, swap bytes to keep the stream order in memory
+    channel_config_set_bswap(&tx_c, size == DMA_SIZE_32);
+    channel_config_set_bswap(&rx_c, size == DMA_SIZE_32);
+}
 
-void __time_critical_func(pio_jtag_write_blocking)(const pio_jtag_inst_t *jtag, const uint8_t *bsrc, size_t len)
+#define PIO_JTAG_ALIGNED(p) ((((uintptr_t)(p)) & 3) == 0)
+
+// Transfer with 32-bit FIFO words and DMA, src and dst (if not NULL) should
+// be word aligned.  TDI data of the last partial word is read by DMA as a
+// whole word (RAM only), TDO bits of the last partial word are stored by CPU.
+static void __time_critical_func(pio_jtag_transfer32)(const pio_jtag_inst_t *jtag, const void *src, bool src_inc,
+                                                      uint8_t *bdst, size_t len, bool tms, bool tms_last)
 {
-    size_t byte_length = (len+7 >> 3);
-    size_t last_shift = ((byte_length << 3) - len);
-    size_t tx_remain = byte_length, rx_remain = last_shift ? byte_length : byte_length+1;
-    io_rw_8 *txfifo = (io_rw_8 *) &jtag->pio->txf[jtag->sm];
-    io_rw_8 *rxfifo = (io_rw_8 *) &jtag->pio->rxf[jtag->sm];
-    uint8_t x; // scratch local to receive data
-    //kick off the process by sending the len to the tx pipeline
-    *(io_rw_32*)txfifo = len-1;
+    size_t words = len >> 5, rem = len & 31;
+    uint32_t x; // scratch local to receive data when TDO is not needed
+    uint32_t tail;
+    uint8_t *last_p;
+    // a transfer shorter than a tick is polled, sleeping would make it last a tick
+    const bool poll = (uint64_t)len * 2 * sio_half_cycles < clock_get_hz(clk_sys) / configTICK_RATE_HZ;
 
-    if (byte_length > 4)
+    pio_jtag_start(jtag, len, tms, tms_last, 32);
+    dma_init();
+    dma_set_size(DMA_SIZE_32);
+    channel_config_set_read_increment(&tx_c, src_inc);
+    channel_config_set_write_increment(&rx_c, bdst != NULL);
+    dma_channel_set_config(rx_dma_chan, &rx_c, false);
+    dma_channel_set_config(tx_dma_chan, &tx_c, false);
+    if (words)
+        dma_channel_transfer_to_buffer_now(rx_dma_chan, bdst ? (void*)bdst : (void*)&x, words);
+    dma_channel_transfer_from_buffer_now(tx_dma_chan, src, words + (rem ? 1 : 0));
+    while (dma_channel_is_busy(rx_dma_chan))
     {
-        dma_init();
-        channel_config_set_read_increment(&tx_c, true);
-        channel_config_set_write_increment(&rx_c, false);
-        dma_channel_set_config(rx_dma_chan, &rx_c, false);
-        dma_channel_set_config(tx_dma_chan, &tx_c, false);
-        dma_channel_transfer_to_buffer_now(rx_dma_chan, (void*)&x, rx_remain);
-        dma_channel_transfer_from_buffer_now(tx_dma_chan, (void*)bsrc, tx_remain);
-        while (dma_channel_is_busy(rx_dma_chan))
+        if (poll)
+            tight_loop_contents();
+        else
+            vTaskDelay(1);
+    }
+    // stop the compiler hoisting a non volatile buffer access above the DMA completion.
+    __compiler_memory_barrier();
+
+    // partial word with the last rem bits, or an empty word pushed at the end
+    while (pio_sm_is_rx_fifo_empty(jtag->pio, jtag->sm))
+        tight_loop_contents();
+    tail = pio_sm_get(jtag->pio, jtag->sm);
+
+    if (rem)
+    {
+        last_tdo = tail & 1;
+        if (bdst)
         {
-          vTaskDelay(1);
-          // jtag_task();
-          // tight_loop_contents();
+            tail <<= 32 - rem;
+            for (size_t i = 0; i < (rem + 7) / 8; i++)
+                bdst[words * 4 + i] = tail >> (24 - 8 * i);
         }
-        // stop the compiler hoisting a non volatile buffer access above the DMA completion.
-        __compiler_memory_barrier();
     }
     else
     {
-        while (tx_remain || rx_remain)
+        last_p = bdst ? &bdst[words * 4 - 1] : &((uint8_t *)&x)[3];
+        last_tdo = *last_p & 1;
+    }
+}
+
+// Word aligned copies of TDI and TDO data for pio_jtag_transfer32(), with a spare word
+#define PIO_JTAG_BOUNCE_BYTES 64
+static uint32_t bounce_src[PIO_JTAG_BOUNCE_BYTES / 4 + 1];
+static uint32_t bounce_dst[PIO_JTAG_BOUNCE_BYTES / 4 + 1];
+
+// Transfer with 32-bit FIFO words from any src and dst (may be NULL), unaligned
+// data goes through the bounce buffers, PIO_JTAG_BOUNCE_BYTES per PIO transfer
+static void __time_critical_func(pio_jtag_transfer32_bounce)(const pio_jtag_inst_t *jtag, const uint8_t *bsrc,
+                                                             uint8_t *bdst, size_t len, bool tms_last)
+{
+    if (PIO_JTAG_ALIGNED(bsrc) && PIO_JTAG_ALIGNED(bdst))
+    {
+        pio_jtag_transfer32(jtag, bsrc, true, bdst, len, false, tms_last);
+        return;
+    }
+    while (len)
+    {
+        size_t n = MIN(len, PIO_JTAG_BOUNCE_BYTES * 8);
+        size_t byte_length = ((n + 7) >> 3);
+        const void *src = bsrc;
+        uint8_t *dst = bdst;
+
+        len -= n;
+        if (!PIO_JTAG_ALIGNED(bsrc))
+        {
+            memcpy(bounce_src, bsrc, byte_length);
+            src = bounce_src;
+        }
+        if (bdst && !PIO_JTAG_ALIGNED(bdst))
+            dst = (uint8_t *)bounce_dst;
+        pio_jtag_transfer32(jtag, src, true, dst, n, false, len ? false : tms_last);
+        if (dst != bdst)
+            memcpy(bdst, bounce_dst, byte_length);
+        bsrc += byte_length;
+        if (bdst)
+            bdst += byte_length;
+    }
+}
+
+
+void __time_critical_func(pio_jtag_write_blocking)(const pio_jtag_inst_t *jtag, const uint8_t *bsrc, size_t len, bool tms_last)
+{
+    size_t byte_length = ((len + 7) >> 3);
+    size_t last_shift = ((byte_length << 3) - len);
+    size_t tx_remain = byte_length, rx_remain = last_shift ? byte_length : byte_length+1;
+    uint8_t x = 0; // scratch local to receive data
+    if (byte_length > 4)
+    {
+        pio_jtag_transfer32_bounce(jtag, bsrc, NULL, len, tms_last);
+        return;
+    }
+    //kick off the process by sending the header with len to the tx pipeline
+    pio_jtag_start(jtag, len, false, tms_last, 8);
+
+    while (tx_remain || rx_remain)
+    {
+        if (tx_remain && !pio_sm_is_tx_fifo_full(jtag->pio, jtag->sm))
+        {
+            pio_jtag_put8(jtag, *bsrc++);
+            --tx_remain;
+        }
+        if (rx_remain && !pio_sm_is_rx_fifo_empty(jtag->pio, jtag->sm))
         {
-            if (tx_remain && !pio_sm_is_tx_fifo_full(jtag->pio, jtag->sm))
-            {
-                *txfifo = *bsrc++;
-                --tx_remain;
-            }
-            if (rx_remain && !pio_sm_is_rx_fifo_empty(jtag->pio, jtag->sm))
-            {
-                x = *rxfifo;
-                --rx_remain;
-            }
+            x = pio_jtag_get8(jtag);
+            --rx_remain;
         }
     }
     last_tdo = !!(x & 1);
 }
 
 void __time_critical_func(pio_jtag_write_read_blocking)(const pio_jtag_inst_t *jtag, const uint8_t *bsrc, uint8_t *bdst,
-                                                         size_t len)
+                                                         size_t len, bool tms_last)
 {
-    size_t byte_length = (len+7 >> 3);
+    size_t byte_length = ((len + 7) >> 3);
     size_t last_shift = ((byte_length << 3) - len);
     size_t tx_remain = byte_length, rx_remain = last_shift ? byte_length : byte_length+1;
     uint8_t* rx_last_byte_p = &bdst[byte_length-1];
-    io_rw_8 *txfifo = (io_rw_8 *) &jtag->pio->txf[jtag->sm];
-    io_rw_8 *rxfifo = (io_rw_8 *) &jtag->pio->rxf[jtag->sm];
-    //kick off the process by sending the len to the tx pipeline
-    *(io_rw_32*)txfifo = len-1;
-
     if (byte_length > 4)
     {
-        dma_init();
-        channel_config_set_read_increment(&tx_c, true);
-        channel_config_set_write_increment(&rx_c, true);
-        dma_channel_set_config(rx_dma_chan, &rx_c, false);
-        dma_channel_set_config(tx_dma_chan, &tx_c, false);
-        dma_channel_transfer_to_buffer_now(rx_dma_chan, (void*)bdst, rx_remain);
-        dma_channel_transfer_from_buffer_now(tx_dma_chan, (void*)bsrc, tx_remain);
-        while (dma_channel_is_busy(rx_dma_chan))
-        {
-          vTaskDelay(1);
-          //  jtag_task();
-          //  tight_loop_contents();
-        }
-        // stop the compiler hoisting a non volatile buffer access above the DMA completion.
-        __compiler_memory_barrier();
+        pio_jtag_transfer32_bounce(jtag, bsrc, bdst, len, tms_last);
+        return;
     }
-    else
+    //kick off the process by sending the header with len to the tx pipeline
+    pio_jtag_start(jtag, len, false, tms_last, 8);
+
+    while (tx_remain || rx_remain)
     {
-        while (tx_remain || rx_remain)
+        if (tx_remain && !pio_sm_is_tx_fifo_full(jtag->pio, jtag->sm))
+        {
+            pio_jtag_put8(jtag, *bsrc++);
+            --tx_remain;
+        }
+        if (rx_remain && !pio_sm_is_rx_fifo_empty(jtag->pio, jtag->sm))
         {
-            if (tx_remain && !pio_sm_is_tx_fifo_full(jtag->pio, jtag->sm))
-            {
-                *txfifo = *bsrc++;
-                --tx_remain;
-            }
-            if (rx_remain && !pio_sm_is_rx_fifo_empty(jtag->pio, jtag->sm))
-            {
-                *bdst++ = *rxfifo;
-                --rx_remain;
-            }
+            *bdst++ = pio_jtag_get8(jtag);
+            --rx_remain;
         }
     }
     last_tdo = !!(*rx_last_byte_p & 1);
@@ -181,61 +334,76 @@ void __time_critical_func(pio_jtag_write_read_blocking)(const pio_jtag_inst_t *j
 
 uint8_t __time_critical_func(pio_jtag_write_tms_blocking)(const pio_jtag_inst_t *jtag, bool tdi, bool tms, size_t len)
 {
-    size_t byte_length = (len+7 >> 3);
+    size_t byte_length = ((len + 7) >> 3);
     size_t last_shift = ((byte_length << 3) - len);
     size_t tx_remain = byte_length, rx_remain = last_shift ? byte_length : byte_length+1;
-    io_rw_8 *txfifo = (io_rw_8 *) &jtag->pio->txf[jtag->sm];
-    io_rw_8 *rxfifo = (io_rw_8 *) &jtag->pio->rxf[jtag->sm];
-    uint8_t x; // scratch local to receive data
+    uint8_t x = 0; // last received byte
     uint8_t tdi_word = tdi ? 0xFF : 0x0;
-    gpio_put(jtag->pin_tms, tms);
-    //kick off the process by sending the len to the tx pipeline
-    *(io_rw_32*)txfifo = len-1;
-
     if (byte_length > 4)
     {
-        dma_init();
-        channel_config_set_read_increment(&tx_c, false);
-        channel_config_set_write_increment(&rx_c, false);
-        dma_channel_set_config(rx_dma_chan, &rx_c, false);
-        dma_channel_set_config(tx_dma_chan, &tx_c, false);
-        dma_channel_transfer_to_buffer_now(rx_dma_chan, (void*)&x, rx_remain);
-        dma_channel_transfer_from_buffer_now(tx_dma_chan, (void*)&tdi_word, tx_remain);
-        while (dma_channel_is_busy(rx_dma_chan))
-        {
-          vTaskDelay(1);
-          //  jtag_task();
-          //  tight_loop_contents();
-        }
-        // stop the compiler hoisting a non volatile buffer access above the DMA completion.
-        __compiler_memory_barrier();
+        uint32_t tdi_word32 = tdi ? 0xFFFFFFFF : 0x0;
+        pio_jtag_transfer32(jtag, &tdi_word32, false, NULL, len, tms, tms);
+        return last_tdo ? 0xFF : 0x00;
     }
-    else
+    //kick off the process by sending the header with len to the tx pipeline
+    pio_jtag_start(jtag, len, tms, tms, 8);
+
+    while (tx_remain || rx_remain)
     {
-        while (tx_remain || rx_remain)
+        if (tx_remain && !pio_sm_is_tx_fifo_full(jtag->pio, jtag->sm))
+        {
+            pio_jtag_put8(jtag, tdi_word);
+            --tx_remain;
+        }
+        if (rx_remain && !pio_sm_is_rx_fifo_empty(jtag->pio, jtag->sm))
         {
-            if (tx_remain && !pio_sm_is_tx_fifo_full(jtag->pio, jtag->sm))
-            {
-                *txfifo = tdi_word;
-                --tx_remain;
-            }
-            if (rx_remain && !pio_sm_is_rx_fifo_empty(jtag->pio, jtag->sm))
-            {
-                x = *rxfifo;
-                --rx_remain;
-            }
+            x = pio_jtag_get8(jtag);
+            --rx_remain;
         }
     }
     last_tdo = !!(x & 1);
     return last_tdo ? 0xFF : 0x00;
 }
 
-static void init_pins(uint pin_tck, uint pin_tdi, uint pin_tdo, uint pin_tms, uint pin_rst, uint pin_trst)
+// Stream bits not shifted yet
+static uint32_t stream_bits;
+
+// The stream is shifted chunk by chunk, each chunk is a PIO transfer of its
+// own (TMS low), so the chunks use 32-bit FIFO words as the blocking transfers
+// do.  TCK stays low between the chunks while the state machine waits for the
+// next header.
+void pio_jtag_stream_start(const pio_jtag_inst_t *jtag, uint32_t len)
+{
+    stream_bits = len;
+}
+
+void pio_jtag_stream_abort(const pio_jtag_inst_t *jtag)
+{
+    // no PIO transfer is left open between the chunks
+    stream_bits = 0;
+}
+
+void __time_critical_func(pio_jtag_stream_write_read)(const pio_jtag_inst_t *jtag, const uint8_t *bsrc, uint8_t *bdst,
+                                                      size_t byte_length)
 {
-    gpio_clr_mask((1u << pin_tms));
-    gpio_init_mask((1u << pin_tms));
-    gpio_set_dir_masked( (1u << pin_tms), 0xffffffffu);
+    while (byte_length && stream_bits)
+    {
+        // only the last chunk may end with a partial byte
+        size_t n = MIN(byte_length, PIO_JTAG_MAX_BITS / 8);
+        uint32_t len = MIN((uint32_t)n * 8, stream_bits);
+
+        jtag_transfer(jtag, len, bsrc, bdst);
+        stream_bits -= len;
+        byte_length -= n;
+        bsrc += n;
+        if (bdst)
+            bdst += n;
+    }
+}
 
+static void init_pins(uint pin_tck, uint pin_tdi, uint pin_tdo, uint pin_tms, uint pin_rst, uint pin_trst)
+{
+    // TMS is driven by the PIO program along with TDI
     gpio_init(pin_tdo);
     gpio_set_dir(pin_tdo, false);
 }
@@ -252,55 +420,156 @@ void init_jtag(pio_jtag_inst_t* jtag, uint freq, uint pin_tck, uint pin_tdi, uin
                     clkdiv,
                     pin_tck,
                     pin_tdi,
-                    pin_tdo
+                    pin_tdo,
+                    pin_tms
                  );
 
     jtag_set_clk_freq(jtag, freq);
 }
 
-void jtag_set_clk_freq(const pio_jtag_inst_t *jtag, uint freq_khz) {
-    uint clk_sys_freq_khz = clock_get_hz(clk_sys) / 1000;
-    float divf = (float)clk_sys_freq_khz / (freq_khz * 4);
-    uint16_t divider = (divf > (int)divf) ? (int)divf + 1 : (int)divf;
-    divider = (divider < 2) ? 2 : divider; //max reliable freq
-    pio_sm_set_clkdiv_int_frac(pio0, jtag->sm, divider, 0);
+uint32_t jtag_set_clk_freq(const pio_jtag_inst_t *jtag, uint freq_khz) {
+    uint32_t clk_sys_freq = clock_get_hz(clk_sys);
+    // 4 PIO cycles per TCK period
+    uint64_t tck_x4 = (uint64_t)(freq_khz ? freq_khz : 1) * 1000 * 4;
+    // 16.8 fixed point divider, rounded up
+    uint64_t div256 = ((uint64_t)clk_sys_freq * 256 + tck_x4 - 1) / tck_x4;
+    div256 = (div256 < 2 * 256) ? 2 * 256 : div256; //max reliable freq
+    div256 = (div256 > 0xffff * 256) ? 0xffff * 256 : div256;
+    pio_sm_set_clkdiv_int_frac(jtag->pio, jtag->sm, div256 >> 8, div256 & 0xff);
+    sio_half_cycles = div256 >> 7;
+    return (uint32_t)(((uint64_t)clk_sys_freq * 256) / (div256 * 4));
 }
 
 void jtag_transfer(const pio_jtag_inst_t *jtag, uint32_t length, const uint8_t* in, uint8_t* out)
 {
-    /* set tms to low */
-    jtag_set_tms(jtag, false);
+    /* tms is low during the transfer */
+    if (out)
+        pio_jtag_write_read_blocking(jtag, in, out, length, false);
+    else
+        pio_jtag_write_blocking(jtag, in, length, false);
+}
 
+void jtag_transfer_exit(const pio_jtag_inst_t *jtag, uint32_t length, const uint8_t* in, uint8_t* out)
+{
+    /* tms is raised on the last bit in the same PIO transfer */
     if (out)
-        pio_jtag_write_read_blocking(jtag, in, out, length);
+        pio_jtag_write_read_blocking(jtag, in, out, length, true);
+    else
+        pio_jtag_write_blocking(jtag, in, length, true);
+}
+
+void jtag_transfer_tms(const pio_jtag_inst_t *jtag, uint32_t length, bool tms, bool tms_last,
+                       const uint8_t* in, uint8_t* out)
+{
+    /* any TMS level, always 32-bit FIFO words */
+    pio_jtag_transfer32(jtag, in, true, out, length, tms, tms_last);
+}
+
+void jtag_set_tms(const pio_jtag_inst_t *jtag, bool value)
+{
+    // PIO state machine is stalled on pull between the transfers
+    tms_level = value;
+    if (sio_owned)
+        gpio_put(jtag->pin_tms, value);
     else
-        pio_jtag_write_blocking(jtag, in, length);
+        pio_sm_exec(jtag->pio, jtag->sm, pio_encode_set(pio_pins, value));
+}
+
+uint32_t jtag_get_clkdiv(const pio_jtag_inst_t *jtag)
+{
+    return jtag->pio->sm[jtag->sm].clkdiv;
+}
+
+void jtag_set_clkdiv(const pio_jtag_inst_t *jtag, uint32_t clkdiv)
+{
+    jtag->pio->sm[jtag->sm].clkdiv = clkdiv;
+    // 16.8 fixed point divider in bits 31..8, two PIO cycles per half period
+    sio_half_cycles = clkdiv >> 15;
+}
+
+static void __time_critical_func(jtag_sio_strobe)(const pio_jtag_inst_t *jtag, uint32_t length, bool tms, bool tdi)
+{
+    const uint32_t tck = 1u << jtag->pin_tck;
+
+    jtag_sio_acquire(jtag);
+    tms_level = tms;
+    gpio_put_masked(sio_pin_mask(jtag), ((uint32_t)tdi << jtag->pin_tdi) | ((uint32_t)tms << jtag->pin_tms));
+    while (length--)
+    {
+        busy_wait_at_least_cycles(sio_half_cycles);
+        gpio_set_mask(tck);
+        busy_wait_at_least_cycles(sio_half_cycles);
+        last_tdo = gpio_get(jtag->pin_tdo);
+        gpio_clr_mask(tck);
+    }
 }
 
 uint8_t jtag_strobe(const pio_jtag_inst_t *jtag, uint32_t length, bool tms, bool tdi)
 {
+    // TMS and TDI are constant, a long run is just several PIO transfers
+    while (length > PIO_JTAG_MAX_BITS)
+    {
+        pio_jtag_write_tms_blocking(jtag, tdi, tms, PIO_JTAG_MAX_BITS);
+        length -= PIO_JTAG_MAX_BITS;
+    }
     if (length == 0)
         return jtag_get_tdo(jtag) ? 0xFF : 0x00;
+    else if (length <= JTAG_SIO_MAX_STROBE)
+        jtag_sio_strobe(jtag, length, tms, tdi);
     else
         return pio_jtag_write_tms_blocking(jtag, tdi, tms, length);
+    return last_tdo ? 0xFF : 0x00;
 }
 
-static uint8_t toggle_bits_out_buffer[4];
-static uint8_t toggle_bits_in_buffer[4];
+void __time_critical_func(jtag_sio_sequence)(const pio_jtag_inst_t *jtag, const uint8_t *states, size_t n, uint8_t *tdo)
+{
+    const uint32_t mask = sio_pin_mask(jtag);
+    bool tck_level;
+
+    jtag_sio_acquire(jtag);
+    tck_level = gpio_get_out_level(jtag->pin_tck);
+    for (size_t i = 0; i < n; i++)
+    {
+        const uint8_t s = states[i];
+        gpio_put_masked(mask, ((s & JTAG_SIO_TCK) ? (1u << jtag->pin_tck) : 0) |
+                              ((s & JTAG_SIO_TDI) ? (1u << jtag->pin_tdi) : 0) |
+                              ((s & JTAG_SIO_TMS) ? (1u << jtag->pin_tms) : 0));
+        busy_wait_at_least_cycles(sio_half_cycles);
+        if ((s & JTAG_SIO_TCK) && !tck_level)
+            last_tdo = gpio_get(jtag->pin_tdo);
+        tck_level = s & JTAG_SIO_TCK;
+        if (tdo && last_tdo)
+            tdo[i >> 3] |= 1u << (i & 7);
+    }
+    tms_level = gpio_get_out_level(jtag->pin_tms);
+}
 
 void jtag_set_tdi(const pio_jtag_inst_t *jtag, bool value)
 {
-    toggle_bits_out_buffer[0] = value ? 1u << 7 : 0;
+    jtag_sio_acquire(jtag);
+    gpio_put(jtag->pin_tdi, value);
 }
 
 void jtag_set_clk(const pio_jtag_inst_t *jtag, bool value)
 {
-    if (value)
+    jtag_sio_acquire(jtag);
+    if (value && !gpio_get_out_level(jtag->pin_tck))
+    {
+        gpio_put(jtag->pin_tck, true);
+        busy_wait_at_least_cycles(sio_half_cycles);
+        last_tdo = gpio_get(jtag->pin_tdo);
+    }
+    else
     {
-        pio_jtag_write_read_blocking(jtag, toggle_bits_out_buffer, toggle_bits_in_buffer, 1);
+        gpio_put(jtag->pin_tck, value);
     }
 }
 
+bool jtag_get_clk(const pio_jtag_inst_t *jtag)
+{
+    return sio_owned && gpio_get_out_level(jtag->pin_tck);
+}
+
 bool jtag_get_tdo(const pio_jtag_inst_t *jtag)
 {
     return last_tdo;
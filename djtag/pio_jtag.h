@@ -40,25 +40,73 @@ typedef struct pio_jtag_inst {
 } pio_jtag_inst_t;
 
 
+// Bits per PIO transfer (30-bit length-1 field of the header, see jtag.pio),
+// longer strobes and streams are split into several transfers
+#define PIO_JTAG_MAX_BITS (1u << 30)
+
 void init_jtag(pio_jtag_inst_t* jtag, uint freq, uint pin_tck, uint pin_tdi, uint pin_tdo, uint pin_tms, uint pin_rst, uint pin_trst);
 
-void pio_jtag_write_blocking(const pio_jtag_inst_t *jtag, const uint8_t *src, size_t len);
+// TMS is low during the transfer, tms_last is the TMS value for the last bit
+void pio_jtag_write_blocking(const pio_jtag_inst_t *jtag, const uint8_t *src, size_t len, bool tms_last);
 
-void pio_jtag_write_read_blocking(const pio_jtag_inst_t *jtag, const uint8_t *src, uint8_t *dst, size_t len);
+void pio_jtag_write_read_blocking(const pio_jtag_inst_t *jtag, const uint8_t *src, uint8_t *dst, size_t len, bool tms_last);
 
 uint8_t pio_jtag_write_tms_blocking(const pio_jtag_inst_t *jtag, bool tdi, bool tms, size_t len);
 
-void jtag_set_clk_freq(const pio_jtag_inst_t *jtag, uint freq_khz);
+// Streaming shift of len bits (TMS low, any length), data is supplied in one or more chunks.
+// dst may be NULL if TDO data is not needed; data beyond len bits is ignored.
+void pio_jtag_stream_start(const pio_jtag_inst_t *jtag, uint32_t len);
+
+void pio_jtag_stream_write_read(const pio_jtag_inst_t *jtag, const uint8_t *src, uint8_t *dst, size_t byte_length);
+
+// Abandon the stream before the final chunk
+void pio_jtag_stream_abort(const pio_jtag_inst_t *jtag);
+
+// Returns the actual TCK frequency in Hz (not above the requested one)
+uint32_t jtag_set_clk_freq(const pio_jtag_inst_t *jtag, uint freq_khz);
 
 void jtag_transfer(const pio_jtag_inst_t *jtag, uint32_t length, const uint8_t* in, uint8_t* out);
 
+// Same as jtag_transfer(), but TMS is raised on the last bit (Shift-xR -> Exit1-xR)
+void jtag_transfer_exit(const pio_jtag_inst_t *jtag, uint32_t length, const uint8_t* in, uint8_t* out);
+
+// TMS is tms during the transfer and tms_last for the last bit,
+// in and out (if not NULL) should be word aligned with a spare word
+void jtag_transfer_tms(const pio_jtag_inst_t *jtag, uint32_t length, bool tms, bool tms_last,
+                       const uint8_t* in, uint8_t* out);
+
+// Strobes up to JTAG_SIO_MAX_STROBE TCK pulses are bit-banged by SIO
+#define JTAG_SIO_MAX_STROBE 8
+
 uint8_t jtag_strobe(const pio_jtag_inst_t *jtag, uint32_t length, bool tms, bool tdi);
 
+// Bit-banged sequence of n pin states, each one lasts half TCK period.
+// TDO is sampled on rising TCK, bit i of tdo (if not NULL, zeroed by the caller)
+// is the last sampled TDO value after state i.
+#define JTAG_SIO_TCK (1u << 0)
+#define JTAG_SIO_TDI (1u << 1)
+#define JTAG_SIO_TMS (1u << 2)
 
-static inline void jtag_set_tms(const pio_jtag_inst_t *jtag, bool value)
+void jtag_sio_sequence(const pio_jtag_inst_t *jtag, const uint8_t *states, size_t n, uint8_t *tdo);
+
+
+void jtag_set_tms(const pio_jtag_inst_t *jtag, bool value);
+
+// Raw PIO clock divider, to restore TCK frequency after a temporary change
+uint32_t jtag_get_clkdiv(const pio_jtag_inst_t *jtag);
+
+void jtag_set_clkdiv(const pio_jtag_inst_t *jtag, uint32_t clkdiv);
+
+// Reverse bit order in a byte, LSB first data <-> PIO order (MSB first)
+static inline uint8_t jtag_rev8(uint8_t b)
 {
-    gpio_put(jtag->pin_tms, value);
+    static const uint8_t rev4[16] = {
+        0x0, 0x8, 0x4, 0xc, 0x2, 0xa, 0x6, 0xe,
+        0x1, 0x9, 0x5, 0xd, 0x3, 0xb, 0x7, 0xf
+    };
+    return (rev4[b & 0xf] << 4) | rev4[b >> 4];
 }
+
 static inline void jtag_set_rst(const pio_jtag_inst_t *jtag, bool value)
 {
     /* Change the direction to out to drive pin to 0 or to in to emulate open drain */
@@ -69,14 +117,18 @@ static inline void jtag_set_trst(const pio_jtag_inst_t *jtag, bool value)
     gpio_put(jtag->pin_trst, value);
 }
 
-// The following APIs assume that they are called in the following order:
-// jtag_set_XXX where XXX is any pin. if XXX is clk it needs to be false
-// jtag_set_clk where clk is true This will initiate a one cycle pio_jtag_write_read_blocking
-// possibly jtag_get_tdo which will get what was read during the previous step
+// The following APIs drive the pins directly (SIO), the pins are given back
+// to the PIO by the next shift:
+// jtag_set_XXX where XXX is any pin
+// jtag_set_clk rising edge samples TDO after half TCK period
+// possibly jtag_get_tdo which will get what was read on the last rising edge
 void jtag_set_tdi(const pio_jtag_inst_t *jtag, bool value);
 
 void jtag_set_clk(const pio_jtag_inst_t *jtag, bool value);
 
+// TCK level, always low while the pins are owned by the PIO
+bool jtag_get_clk(const pio_jtag_inst_t *jtag);
+
 bool jtag_get_tdo(const pio_jtag_inst_t *jtag);
 
 
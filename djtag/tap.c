@@ -0,0 +1,166 @@
+/*
+ * Raspberry Pi RP2040 Control firmware for GMM-7550 module
+ * https://www.gmm7550.dev/doc/rp2040.html
+ *
+ * Copyright (c) 2026 Anton Kuzmin <ak@gmm7550.dev>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <string.h>
+#include <strings.h>
+
+#include "pico/stdlib.h"
+#include "pio_jtag.h"
+#include "tap.h"
+
+/* Next state for TMS = 0 and TMS = 1 */
+static const uint8_t tap_next[TAP_N_STATES][2] = {
+  [TAP_RESET]     = {TAP_IDLE,      TAP_RESET},
+  [TAP_IDLE]      = {TAP_IDLE,      TAP_DRSELECT},
+  [TAP_DRSELECT]  = {TAP_DRCAPTURE, TAP_IRSELECT},
+  [TAP_DRCAPTURE] = {TAP_DRSHIFT,   TAP_DREXIT1},
+  [TAP_DRSHIFT]   = {TAP_DRSHIFT,   TAP_DREXIT1},
+  [TAP_DREXIT1]   = {TAP_DRPAUSE,   TAP_DRUPDATE},
+  [TAP_DRPAUSE]   = {TAP_DRPAUSE,   TAP_DREXIT2},
+  [TAP_DREXIT2]   = {TAP_DRSHIFT,   TAP_DRUPDATE},
+  [TAP_DRUPDATE]  = {TAP_IDLE,      TAP_DRSELECT},
+  [TAP_IRSELECT]  = {TAP_IRCAPTURE, TAP_RESET},
+  [TAP_IRCAPTURE] = {TAP_IRSHIFT,   TAP_IREXIT1},
+  [TAP_IRSHIFT]   = {TAP_IRSHIFT,   TAP_IREXIT1},
+  [TAP_IREXIT1]   = {TAP_IRPAUSE,   TAP_IRUPDATE},
+  [TAP_IRPAUSE]   = {TAP_IRPAUSE,   TAP_IREXIT2},
+  [TAP_IREXIT2]   = {TAP_IRSHIFT,   TAP_IRUPDATE},
+  [TAP_IRUPDATE]  = {TAP_IDLE,      TAP_DRSELECT},
+};
+
+static const char *tap_names[TAP_N_STATES + 1] = {
+  "RESET",     "IDLE",
+  "DRSELECT",  "DRCAPTURE", "DRSHIFT",  "DREXIT1",
+  "DRPAUSE",   "DREXIT2",   "DRUPDATE",
+  "IRSELECT",  "IRCAPTURE", "IRSHIFT",  "IREXIT1",
+  "IRPAUSE",   "IREXIT2",   "IRUPDATE",
+  "UNKNOWN"
+};
+
+static tap_state_t tap_state = TAP_UNKNOWN;
+
+tap_state_t tap_get_state(void)
+{
+  return tap_state;
+}
+
+void tap_invalidate(void)
+{
+  tap_state = TAP_UNKNOWN;
+}
+
+void tap_clocked(bool tms, uint32_t len)
+{
+  if (tap_state == TAP_UNKNOWN) {
+    /* five or more TMS=1 cycles bring TAP to reset from any state */
+    if (tms && len >= 5) tap_state = TAP_RESET;
+    return;
+  }
+  /* every state settles after a few cycles with constant TMS */
+  if (len > 8) len = 8;
+  while (len--) tap_state = tap_next[tap_state][tms];
+}
+
+void tap_reset(const pio_jtag_inst_t *jtag)
+{
+  jtag_strobe(jtag, 5, true, false);
+  tap_state = TAP_RESET;
+}
+
+/* Breadth-first search of the shortest TMS path, at most 8 bits long */
+static uint tap_path(tap_state_t from, tap_state_t to, uint8_t *tms)
+{
+  uint8_t prev[TAP_N_STATES];
+  uint8_t queue[TAP_N_STATES];
+  uint head = 0, tail = 0;
+  uint len = 0;
+
+  memset(prev, 0xff, sizeof(prev));
+  prev[from] = from;
+  queue[tail++] = from;
+  while (head < tail && prev[to] == 0xff) {
+    uint8_t s = queue[head++];
+    for (int t = 0; t < 2; t++) {
+      uint8_t n = tap_next[s][t];
+      if (prev[n] == 0xff) {
+        prev[n] = s;
+        queue[tail++] = n;
+      }
+    }
+  }
+
+  /* walk back from the target state, collecting TMS bits */
+  for (uint8_t s = to; s != from; s = prev[s]) {
+    *tms = (*tms << 1) | (tap_next[prev[s]][1] == s);
+    len++;
+  }
+  return len;
+}
+
+void tap_goto(const pio_jtag_inst_t *jtag, tap_state_t state)
+{
+  uint8_t tms = 0;
+  uint len;
+
+  if (tap_state == TAP_UNKNOWN || state == TAP_RESET) {
+    tap_reset(jtag);
+  }
+  if (tap_state == state) return;
+
+  len = tap_path(tap_state, state, &tms);
+  /* first TMS bit of the path is the LSB, clock runs of equal bits together */
+  while (len) {
+    bool t = tms & 1;
+    uint run = 0;
+    while (len && ((tms & 1) == t)) {
+      tms >>= 1; len--; run++;
+    }
+    jtag_strobe(jtag, run, t, false);
+  }
+  tap_state = state;
+}
+
+void tap_shift_bits(const pio_jtag_inst_t *jtag, const uint8_t *tdi, uint8_t *tdo,
+                    uint32_t nbits, bool exit)
+{
+  if (nbits == 0) return;
+  if (exit) {
+    /* TMS is raised on the last bit by the PIO in the same transfer */
+    jtag_transfer_exit(jtag, nbits, tdi, tdo);
+    tap_state = tap_next[tap_state][1];
+  } else {
+    jtag_transfer(jtag, nbits, tdi, tdo);
+  }
+}
+
+void tap_shift(const pio_jtag_inst_t *jtag, bool ir, const uint8_t *tdi, uint8_t *tdo,
+               uint32_t nbits, tap_state_t end_state)
+{
+  tap_goto(jtag, ir ? TAP_IRSHIFT : TAP_DRSHIFT);
+  tap_shift_bits(jtag, tdi, tdo, nbits, true);
+  tap_goto(jtag, end_state);
+}
+
+void tap_run(const pio_jtag_inst_t *jtag, uint32_t len)
+{
+  if (len) jtag_strobe(jtag, len, tap_state == TAP_RESET, false);
+}
+
+tap_state_t tap_state_by_name(const char *name)
+{
+  for (int s = 0; s < TAP_N_STATES; s++) {
+    if (strcasecmp(name, tap_names[s]) == 0) return s;
+  }
+  return TAP_UNKNOWN;
+}
+
+const char *tap_state_name(tap_state_t state)
+{
+  return tap_names[(state < TAP_N_STATES) ? state : TAP_UNKNOWN];
+}
@@ -0,0 +1,73 @@
+/*
+ * Raspberry Pi RP2040 Control firmware for GMM-7550 module
+ * https://www.gmm7550.dev/doc/rp2040.html
+ *
+ * Copyright (c) 2026 Anton Kuzmin <ak@gmm7550.dev>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* JTAG TAP state tracking on top of the PIO JTAG engine */
+
+#ifndef _TAP_H
+#define _TAP_H
+
+#include "pio_jtag.h"
+
+typedef enum tap_state {
+  TAP_RESET = 0,
+  TAP_IDLE,
+  TAP_DRSELECT,
+  TAP_DRCAPTURE,
+  TAP_DRSHIFT,
+  TAP_DREXIT1,
+  TAP_DRPAUSE,
+  TAP_DREXIT2,
+  TAP_DRUPDATE,
+  TAP_IRSELECT,
+  TAP_IRCAPTURE,
+  TAP_IRSHIFT,
+  TAP_IREXIT1,
+  TAP_IRPAUSE,
+  TAP_IREXIT2,
+  TAP_IRUPDATE,
+  TAP_N_STATES,
+  TAP_UNKNOWN = TAP_N_STATES
+} tap_state_t;
+
+/* Current (tracked) TAP state */
+tap_state_t tap_get_state(void);
+
+/* Forget the TAP state, next tap_goto() will start with a TAP reset */
+void tap_invalidate(void);
+
+/* Update the tracked state after len TCK cycles with constant TMS */
+void tap_clocked(bool tms, uint32_t len);
+
+/* Five TMS=1 cycles, TAP is in Test-Logic-Reset afterwards */
+void tap_reset(const pio_jtag_inst_t *jtag);
+
+/* Move TAP to the given state by the shortest TMS path */
+void tap_goto(const pio_jtag_inst_t *jtag, tap_state_t state);
+
+/*
+ * Shift nbits in the Shift-IR/Shift-DR state.  Data is in DirtyJTAG
+ * order (byte by byte, MSB first).  tdo may be NULL, otherwise it
+ * should have room for (nbits+7)/8 + 1 bytes.  If exit is set, TMS is
+ * raised on the last bit and TAP moves to Exit1 state.
+ */
+void tap_shift_bits(const pio_jtag_inst_t *jtag, const uint8_t *tdi, uint8_t *tdo,
+                    uint32_t nbits, bool exit);
+
+/* Complete IR or DR scan: go to Shift-xR, shift with exit, go to end_state */
+void tap_shift(const pio_jtag_inst_t *jtag, bool ir, const uint8_t *tdi, uint8_t *tdo,
+               uint32_t nbits, tap_state_t end_state);
+
+/* Clock len cycles staying in a stable state (TMS=1 in Test-Logic-Reset) */
+void tap_run(const pio_jtag_inst_t *jtag, uint32_t len);
+
+/* Parse/print state names as used by SVF (RESET, IDLE, DRPAUSE...) */
+tap_state_t tap_state_by_name(const char *name);
+const char *tap_state_name(tap_state_t state);
+
+#endif
@@ -0,0 +1,90 @@
+/*
+ * Raspberry Pi RP2040 Control firmware for GMM-7550 module
+ * https://www.gmm7550.dev/doc/rp2040.html
+ *
+ * Copyright (c) 2026 Anton Kuzmin <ak@gmm7550.dev>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "pico/stdlib.h"
+#include "trace.h"
+
+#if GMM7550_DJTAG_TRACE
+
+_Static_assert((GMM7550_DJTAG_TRACE_SIZE & (GMM7550_DJTAG_TRACE_SIZE - 1)) == 0,
+               "trace size should be a power of 2");
+
+#define TRACE_MASK (GMM7550_DJTAG_TRACE_SIZE - 1)
+
+static djtag_trace_t trace[GMM7550_DJTAG_TRACE_SIZE];
+
+/* Free running entry counters: JTAG task writes head and queued,
+ * USB device task writes flushed (one IN transfer at a time)
+ */
+static volatile uint32_t trace_head;
+static volatile uint32_t trace_queued;
+static volatile uint32_t trace_flushed;
+
+static uint8_t trace_buffer;
+
+void trace_packet(uint8_t buffer)
+{
+  trace_buffer = buffer;
+}
+
+void trace_cmd_start(uint8_t opcode)
+{
+  djtag_trace_t *t = &trace[trace_head & TRACE_MASK];
+
+  t->opcode = opcode;
+  t->buffer = trace_buffer;
+  t->bits = 0;
+  t->t_done = t->t_flushed = 0;
+  t->t_start = time_us_32();
+}
+
+void trace_cmd_done(uint32_t bits)
+{
+  djtag_trace_t *t = &trace[trace_head & TRACE_MASK];
+
+  t->t_done = time_us_32();
+  t->bits = bits;
+  trace_head++;
+}
+
+void trace_tx_queued(void)
+{
+  trace_queued = trace_head;
+}
+
+void trace_tx_done(void)
+{
+  const uint32_t now = time_us_32();
+  uint32_t i = trace_flushed;
+
+  /* entries overwritten in the meantime are skipped */
+  if (trace_queued - i > GMM7550_DJTAG_TRACE_SIZE)
+    i = trace_queued - GMM7550_DJTAG_TRACE_SIZE;
+  for (; i != trace_queued; i++) {
+    trace[i & TRACE_MASK].t_flushed = now;
+  }
+  trace_flushed = i;
+}
+
+void trace_clear(void)
+{
+  trace_head = trace_queued = trace_flushed = 0;
+}
+
+uint32_t trace_count(void)
+{
+  return MIN(trace_head, GMM7550_DJTAG_TRACE_SIZE);
+}
+
+const djtag_trace_t *trace_get(uint32_t i)
+{
+  return &trace[(trace_head - trace_count() + i) & TRACE_MASK];
+}
+
+#endif
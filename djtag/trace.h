@@ -0,0 +1,68 @@
+/*
+ * Raspberry Pi RP2040 Control firmware for GMM-7550 module
+ * https://www.gmm7550.dev/doc/rp2040.html
+ *
+ * Copyright (c) 2026 Anton Kuzmin <ak@gmm7550.dev>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* DirtyJTAG command trace (GMM7550_DJTAG_TRACE build option)
+ *
+ * Executed commands are recorded into a RAM ring with time stamps in
+ * microseconds (time_us_32()): command start, command done (PIO/DMA
+ * transfer is complete) and the end of the first IN transfer sent
+ * after the command (its reply, if any, is on the way to the host).
+ */
+
+#ifndef _TRACE_H
+#define _TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef GMM7550_DJTAG_TRACE_SIZE
+#define GMM7550_DJTAG_TRACE_SIZE 256 /* entries, power of 2 */
+#endif
+
+/* CMD_XFER_LONG data continued in the following packets */
+#define TRACE_OP_DATA 0xff
+
+typedef struct djtag_trace {
+  uint32_t t_start;
+  uint32_t t_done;
+  uint32_t t_flushed; /* 0 -- not yet */
+  uint32_t bits;
+  uint8_t opcode;     /* command byte with modifiers */
+  uint8_t buffer;     /* command buffer index */
+} djtag_trace_t;
+
+#if GMM7550_DJTAG_TRACE
+
+/* Command packet from the given buffer is being executed */
+void trace_packet(uint8_t buffer);
+
+void trace_cmd_start(uint8_t opcode);
+void trace_cmd_done(uint32_t bits);
+
+/* IN transfer is started, and is complete */
+void trace_tx_queued(void);
+void trace_tx_done(void);
+
+void trace_clear(void);
+
+/* Number of recorded entries, and entry i of them (oldest first) */
+uint32_t trace_count(void);
+const djtag_trace_t *trace_get(uint32_t i);
+
+#else
+
+static inline void trace_packet(uint8_t buffer) {}
+static inline void trace_cmd_start(uint8_t opcode) {}
+static inline void trace_cmd_done(uint32_t bits) {}
+static inline void trace_tx_queued(void) {}
+static inline void trace_tx_done(void) {}
+
+#endif
+
+#endif
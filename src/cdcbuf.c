@@ -0,0 +1,274 @@
+/*
+ * Raspberry Pi RP2040 Control firmware for GMM-7550 module
+ * https://www.gmm7550.dev/doc/rp2040.html
+ *
+ * Copyright (c) 2026 Anton Kuzmin <ak@gmm7550.dev>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* Receive and transmit rings of the CDC channels, sized by the USB
+ * buffer profile (profile.c).
+ *
+ * The rings sit between TinyUSB FIFOs and the channel tasks: the
+ * tud_cdc_n_*() read and write functions are wrapped by the linker
+ * (--wrap, see CMakeLists.txt), so the channel code is not changed.
+ * Received packets are moved from the FIFO into the ring in the USB
+ * device task as they arrive, so the OUT endpoint is armed again right
+ * away; data written by a channel go to the FIFO directly while there
+ * is room, the rest waits in the ring and is moved to the FIFO as the
+ * IN transfers complete.  A channel with no rings (size 0) uses the
+ * FIFOs as before.
+ *
+ * Ring sizes are powers of two, indices are free running.  A mutex per
+ * channel serializes the channel task and USB device task.
+ */
+
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "gmm7550_control.h"
+#include "tusb.h"
+#include "semphr.h"
+
+typedef struct {
+  uint8_t *buf;
+  uint32_t size; /* 0 -- no ring */
+  uint32_t head; /* write */
+  uint32_t tail; /* read */
+} ring_t;
+
+typedef struct {
+  SemaphoreHandle_t lock;
+  ring_t rx;
+  ring_t tx;
+} cdc_rings_t;
+
+static cdc_rings_t cdc_rings[CFG_TUD_CDC];
+
+extern uint32_t __real_tud_cdc_n_available(uint8_t itf);
+extern uint32_t __real_tud_cdc_n_read(uint8_t itf, void *buffer, uint32_t bufsize);
+extern bool __real_tud_cdc_n_peek(uint8_t itf, uint8_t *u8);
+extern void __real_tud_cdc_n_read_flush(uint8_t itf);
+extern uint32_t __real_tud_cdc_n_write(uint8_t itf, void const *buffer, uint32_t bufsize);
+extern uint32_t __real_tud_cdc_n_write_available(uint8_t itf);
+
+static inline uint32_t ring_count(const ring_t *r)
+{
+  return r->head - r->tail;
+}
+
+static inline uint32_t ring_free(const ring_t *r)
+{
+  return r->size - ring_count(r);
+}
+
+/* Contiguous free space at head */
+static inline uint32_t ring_wr_span(const ring_t *r)
+{
+  return MIN(ring_free(r), r->size - (r->head & (r->size - 1)));
+}
+
+/* Contiguous data at tail */
+static inline uint32_t ring_rd_span(const ring_t *r)
+{
+  return MIN(ring_count(r), r->size - (r->tail & (r->size - 1)));
+}
+
+static uint32_t ring_put(ring_t *r, const uint8_t *p, uint32_t len)
+{
+  uint32_t n, done = 0;
+
+  while (done < len && (n = MIN(ring_wr_span(r), len - done))) {
+    memcpy(r->buf + (r->head & (r->size - 1)), p + done, n);
+    r->head += n;
+    done += n;
+  }
+  return done;
+}
+
+static uint32_t ring_get(ring_t *r, uint8_t *p, uint32_t len)
+{
+  uint32_t n, done = 0;
+
+  while (done < len && (n = MIN(ring_rd_span(r), len - done))) {
+    memcpy(p + done, r->buf + (r->tail & (r->size - 1)), n);
+    r->tail += n;
+    done += n;
+  }
+  return done;
+}
+
+/* TinyUSB FIFO -> RX ring, with the channel lock taken */
+static void rx_fill(uint8_t itf)
+{
+  ring_t *r = &cdc_rings[itf].rx;
+  uint32_t n;
+
+  while ((n = ring_wr_span(r))) {
+    n = __real_tud_cdc_n_read(itf, r->buf + (r->head & (r->size - 1)), n);
+    if (!n) break;
+    r->head += n;
+  }
+}
+
+/* TX ring -> TinyUSB FIFO, with the channel lock taken */
+static void tx_drain(uint8_t itf)
+{
+  ring_t *r = &cdc_rings[itf].tx;
+  uint32_t n, len;
+
+  while ((len = ring_rd_span(r))) {
+    n = __real_tud_cdc_n_write(itf, r->buf + (r->tail & (r->size - 1)), len);
+    r->tail += n;
+    if (n < len) break;
+  }
+}
+
+static inline void cdc_lock(uint8_t itf)
+{
+  xSemaphoreTake(cdc_rings[itf].lock, portMAX_DELAY);
+}
+
+static inline void cdc_unlock(uint8_t itf)
+{
+  xSemaphoreGive(cdc_rings[itf].lock);
+}
+
+uint32_t __wrap_tud_cdc_n_available(uint8_t itf)
+{
+  uint32_t n;
+
+  if (!cdc_rings[itf].rx.size) return __real_tud_cdc_n_available(itf);
+  cdc_lock(itf);
+  rx_fill(itf);
+  n = ring_count(&cdc_rings[itf].rx);
+  cdc_unlock(itf);
+  return n;
+}
+
+uint32_t __wrap_tud_cdc_n_read(uint8_t itf, void *buffer, uint32_t bufsize)
+{
+  uint32_t n;
+
+  if (!cdc_rings[itf].rx.size) return __real_tud_cdc_n_read(itf, buffer, bufsize);
+  cdc_lock(itf);
+  rx_fill(itf);
+  n = ring_get(&cdc_rings[itf].rx, buffer, bufsize);
+  rx_fill(itf); /* what was left in the FIFO while the ring was full */
+  cdc_unlock(itf);
+  return n;
+}
+
+bool __wrap_tud_cdc_n_peek(uint8_t itf, uint8_t *u8)
+{
+  ring_t *r = &cdc_rings[itf].rx;
+  bool ok;
+
+  if (!r->size) return __real_tud_cdc_n_peek(itf, u8);
+  cdc_lock(itf);
+  rx_fill(itf);
+  if ((ok = ring_count(r) > 0)) *u8 = r->buf[r->tail & (r->size - 1)];
+  cdc_unlock(itf);
+  return ok;
+}
+
+void __wrap_tud_cdc_n_read_flush(uint8_t itf)
+{
+  ring_t *r = &cdc_rings[itf].rx;
+
+  if (!r->size) {
+    __real_tud_cdc_n_read_flush(itf);
+    return;
+  }
+  cdc_lock(itf);
+  __real_tud_cdc_n_read_flush(itf);
+  r->tail = r->head;
+  cdc_unlock(itf);
+}
+
+uint32_t __wrap_tud_cdc_n_write(uint8_t itf, void const *buffer, uint32_t bufsize)
+{
+  ring_t *r = &cdc_rings[itf].tx;
+  uint32_t n;
+
+  if (!r->size) {
+    n = __real_tud_cdc_n_write(itf, buffer, bufsize);
+  } else {
+    cdc_lock(itf);
+    /* FIFO first, unless the ring holds older data */
+    tx_drain(itf);
+    n = ring_count(r) ? 0 : __real_tud_cdc_n_write(itf, buffer, bufsize);
+    n += ring_put(r, (const uint8_t *)buffer + n, bufsize - n);
+    cdc_unlock(itf);
+  }
+  if (n < bufsize) usbstat_full(usb_channels[USB_CHANNEL_CDC(itf)].ep_in);
+  return n;
+}
+
+uint32_t __wrap_tud_cdc_n_write_available(uint8_t itf)
+{
+  uint32_t n;
+
+  if (!cdc_rings[itf].tx.size) return __real_tud_cdc_n_write_available(itf);
+  cdc_lock(itf);
+  n = ring_free(&cdc_rings[itf].tx) + (ring_count(&cdc_rings[itf].tx) ? 0 : __real_tud_cdc_n_write_available(itf));
+  cdc_unlock(itf);
+  return n;
+}
+
+/*
+ * TinyUSB CDC callbacks, USB device task
+ */
+void tud_cdc_rx_cb(uint8_t itf)
+{
+  if (cdc_rings[itf].rx.size) {
+    cdc_lock(itf);
+    rx_fill(itf);
+    cdc_unlock(itf);
+  }
+  /* No room for another packet: the OUT endpoint stays idle (NAK)
+   * until the channel reads from the ring or FIFO */
+  if (__real_tud_cdc_n_available(itf) > CFG_TUD_CDC_RX_BUFSIZE - CFG_TUD_CDC_EP_BUFSIZE) {
+    usbstat_full(usb_channels[USB_CHANNEL_CDC(itf)].ep_out);
+  }
+}
+
+void tud_cdc_tx_complete_cb(uint8_t itf)
+{
+  if (!cdc_rings[itf].tx.size) return;
+  cdc_lock(itf);
+  tx_drain(itf);
+  cdc_unlock(itf);
+  tud_cdc_n_write_flush(itf);
+}
+
+/* Drop the data of a closed channel, so a new session does not get the
+ * leftovers of the previous one (TinyUSB FIFOs are cleared on bus reset) */
+void cdcbuf_clear(uint8_t itf)
+{
+  cdc_rings_t *c = &cdc_rings[itf];
+
+  if (!c->rx.size && !c->tx.size) return;
+  cdc_lock(itf);
+  c->rx.tail = c->rx.head;
+  c->tx.tail = c->tx.head;
+  cdc_unlock(itf);
+}
+
+/* Rings of the active USB buffer profile */
+void cdcbuf_init(void)
+{
+  cdc_rings_t *c;
+  uint32_t rx, tx;
+
+  for (uint i = 0; i < CFG_TUD_CDC; i++) {
+    c = &cdc_rings[i];
+    rx = usb_profile->cdc_rx[i];
+    tx = usb_profile->cdc_tx[i];
+    if ((rx & (rx - 1)) || (tx & (tx - 1))) continue; /* not a power of two */
+    if (rx && (c->rx.buf = usb_profile_alloc(rx))) c->rx.size = rx;
+    if (tx && (c->tx.buf = usb_profile_alloc(tx))) c->tx.size = tx;
+    if (c->rx.size || c->tx.size) c->lock = xSemaphoreCreateMutex();
+  }
+}
@@ -1,3 +1,5 @@
+#include <string.h>
+
 #include "pico/bootrom.h"
 #include "gmm7550_control.h"
 #include "tusb.h"
@@ -26,22 +28,42 @@ static inline uint8_t cdc_getc(const uint cdc)
   }
 }
 
+/* CLI output goes to the CDC FIFO in runs, a packet is sent when the
+ * FIFO is full (TinyUSB) and at the end of a line or prompt (cdc_puts)
+ * or an echoed character (cdc_putc), not after every character */
+static void cdc_write(const uint cdc, const uint8_t *p, uint32_t len)
+{
+  uint32_t n;
+
+  while (len) {
+    n = tud_cdc_n_write(cdc, p, len);
+    p += n;
+    len -= n;
+    if (len) {
+      tud_cdc_n_write_flush(cdc);
+      vTaskDelay(1);
+    }
+  }
+}
+
 static inline void cdc_putc(const uint cdc, const uint8_t c)
 {
-  while(!tud_cdc_n_write_available(cdc)) vTaskDelay(1);
-  tud_cdc_n_write_char(cdc, c);
+  cdc_write(cdc, &c, 1);
   tud_cdc_n_write_flush(cdc);
 }
 
+/* '\n' -> "\n\r", the text in between is written as is */
 static void cdc_puts(const uint cdc, const uint8_t *s)
 {
-  const uint8_t *p = s;
-  uint8_t c;
+  const uint8_t *nl;
 
-  while ((c = *p++)) {
-    cdc_putc(cdc, c);
-    if (c == '\n') cdc_putc(cdc, '\r');
+  while ((nl = (const uint8_t *)strchr((const char *)s, '\n'))) {
+    cdc_write(cdc, s, nl - s + 1);
+    cdc_write(cdc, "\r", 1);
+    s = nl + 1;
   }
+  cdc_write(cdc, s, strlen((const char *)s));
+  tud_cdc_n_write_flush(cdc);
 }
 
 static uint8_t *cdc_get_line(const uint cdc)
@@ -100,9 +122,14 @@ static const CLI_Command_Definition_t bootsel_cmd = {
 
 static void print_version_info(void)
 {
-  puts("Version    : " GMM7550_CONTROL_VERSION "\n");
-  puts("Git hash   : "); puts(git_hash_str); puts("\n");
-  puts("Build time : "); puts(build_time_str); puts("\n");
+  static char s[160];
+
+  snprintf(s, sizeof(s),
+           "Version    : " GMM7550_CONTROL_VERSION "\n"
+           "Git hash   : %s\n"
+           "Build time : %s\n",
+           git_hash_str, build_time_str);
+  puts(s);
 }
 
 static BaseType_t cli_version(char *pcWriteBuffer,
@@ -142,6 +169,16 @@ void cli_task(__unused void *params)
   cli_register_i2c();
   cli_register_pll();
   cli_register_adc();
+  cli_register_jtag();
+  cli_register_jpipe();
+  cli_register_usbstat();
+  cli_register_profile();
+#if GMM7550_MSC
+  cli_register_msc();
+#endif
+#if GMM7550_DFU
+  cli_register_dfu();
+#endif
   FreeRTOS_CLIRegisterCommand(&bootsel_cmd);
   FreeRTOS_CLIRegisterCommand(&version_cmd);
 
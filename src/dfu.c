@@ -0,0 +1,275 @@
+/*
+ * Raspberry Pi RP2040 Control firmware for GMM-7550 module
+ * https://www.gmm7550.dev/doc/rp2040.html
+ *
+ * Copyright (c) 2026 Anton Kuzmin <ak@gmm7550.dev>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* Firmware update over USB DFU, without BOOTSEL.
+ *
+ * DFU interface (DFU mode protocol, one alternate setting) is a part of
+ * the composite device, so dfu-util downloads to it directly:
+ *
+ *   dfu-util -d 1209:c0ca -a 0 -D gmm_control.dfu
+ *
+ * The image is the firmware binary with a trailer (magic, length,
+ * CRC-32) appended by tools/gmm7550_dfu.py.  It is written to the
+ * staging area, the upper half of the 2 MiB flash, erased by 64 KiB
+ * blocks on the first touch.  On manifestation the trailer, the vector
+ * table and the CRC of the staged image (read back from flash) are
+ * checked; the running firmware is not touched if any of them fails.
+ * Otherwise, once the host has got the status, the device disconnects,
+ * the image is copied over the running firmware by a function running
+ * from RAM with interrupts disabled, and the chip is rebooted by the
+ * watchdog.  The copy takes well under a second; should it be broken
+ * by a power loss, BOOTSEL and uf2 are still there.
+ */
+
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+#include "hardware/sync.h"
+#include "hardware/watchdog.h"
+#include "hardware/structs/psm.h"
+#include "gmm7550_control.h"
+#include "tusb.h"
+#include "FreeRTOS_CLI.h"
+
+#define DFU_STAGE_OFFSET  (PICO_FLASH_SIZE_BYTES / 2)
+#define DFU_STAGE_SIZE    (PICO_FLASH_SIZE_BYTES - DFU_STAGE_OFFSET)
+#define DFU_STAGE_ADDR    (XIP_BASE + DFU_STAGE_OFFSET)
+#define DFU_ERASE_SIZE    (64 * 1024) /* flash block erase */
+
+#define DFU_SWAP_DELAY_MS 500 /* host reads the final status meanwhile */
+
+/* Appended to the firmware binary, little endian */
+typedef struct {
+  uint32_t magic;
+  uint32_t length;  /* of the firmware, trailer is not included */
+  uint32_t crc;     /* CRC-32 (IEEE 802.3) of the firmware */
+  uint32_t reserved;
+} dfu_trailer_t;
+
+#define DFU_TRAILER_MAGIC 0x55464d47 /* "GMFU" */
+
+#if CFG_TUD_DFU_XFER_BUFSIZE % FLASH_PAGE_SIZE
+#error "DFU transfer size should be a multiple of the flash page"
+#endif
+
+extern char __flash_binary_end;
+
+static uint32_t dfu_received;   /* bytes in the staging area */
+static uint32_t dfu_erased;     /* bitmap of the erased 64 KiB blocks */
+static uint32_t dfu_length;     /* verified image length */
+static const char *dfu_result = "no update since reboot";
+static TaskHandle_t dfu_task_handle;
+
+/* Last block is padded up to the flash page, whole sectors are copied
+ * by dfu_swap() */
+static uint8_t dfu_buf[MAX(CFG_TUD_DFU_XFER_BUFSIZE, FLASH_SECTOR_SIZE)] __aligned(4);
+
+static uint32_t crc32(const uint8_t *p, uint32_t len)
+{
+  static const uint32_t t[16] = {
+    0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac,
+    0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+    0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c,
+    0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c
+  };
+  uint32_t crc = 0xffffffff;
+
+  while (len--) {
+    crc ^= *p++;
+    crc = (crc >> 4) ^ t[crc & 0x0f];
+    crc = (crc >> 4) ^ t[crc & 0x0f];
+  }
+  return ~crc;
+}
+
+static void dfu_flash_erase(uint32_t offs, size_t len)
+{
+  const uint32_t irq = save_and_disable_interrupts();
+  flash_range_erase(offs, len);
+  restore_interrupts(irq);
+}
+
+static void dfu_flash_program(uint32_t offs, const uint8_t *data, size_t len)
+{
+  const uint32_t irq = save_and_disable_interrupts();
+  flash_range_program(offs, data, len);
+  restore_interrupts(irq);
+}
+
+/* Copy the staged image over the running firmware and reboot.
+ * Nothing in flash may be called from here. */
+static void __no_inline_not_in_flash_func(dfu_swap)(uint32_t len)
+{
+  const volatile uint32_t *src;
+  uint32_t *dst;
+
+  save_and_disable_interrupts();
+  for (uint32_t blk = 0; blk < len; blk += DFU_ERASE_SIZE) {
+    flash_range_erase(blk, DFU_ERASE_SIZE);
+    for (uint32_t s = blk; s < blk + DFU_ERASE_SIZE && s < len; s += FLASH_SECTOR_SIZE) {
+      /* word by word, not to let the compiler call memcpy() in flash */
+      src = (const volatile uint32_t *)(DFU_STAGE_ADDR + s);
+      dst = (uint32_t *)dfu_buf;
+      for (uint i = 0; i < FLASH_SECTOR_SIZE / 4; i++) dst[i] = src[i];
+      flash_range_program(s, dfu_buf, FLASH_SECTOR_SIZE);
+    }
+  }
+  /* watchdog_reboot() is in flash, do the same here */
+  watchdog_hw->scratch[4] = 0;
+  hw_set_bits(&psm_hw->wdsel, PSM_WDSEL_BITS & ~(PSM_WDSEL_ROSC_BITS | PSM_WDSEL_XOSC_BITS));
+  hw_set_bits(&watchdog_hw->ctrl, WATCHDOG_CTRL_TRIGGER_BITS);
+  while (1) tight_loop_contents();
+}
+
+static void dfu_task(__unused void *params)
+{
+  while (1) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    vTaskDelay(DFU_SWAP_DELAY_MS / portTICK_PERIOD_MS);
+    tud_disconnect();
+    vTaskDelay(10 / portTICK_PERIOD_MS);
+    dfu_swap(dfu_length);
+  }
+}
+
+static uint8_t dfu_verify(void)
+{
+  const dfu_trailer_t *t;
+  const uint32_t *vectors;
+  uint32_t len;
+
+  if (dfu_received < sizeof(dfu_trailer_t)) {
+    dfu_result = "image is too short";
+    return DFU_STATUS_ERR_FILE;
+  }
+  len = dfu_received - sizeof(dfu_trailer_t);
+  t = (const dfu_trailer_t *)(DFU_STAGE_ADDR + len);
+  if (t->magic != DFU_TRAILER_MAGIC || t->length != len) {
+    dfu_result = "no valid trailer, see tools/gmm7550_dfu.py";
+    return DFU_STATUS_ERR_FILE;
+  }
+  /* boot2 is followed by the vector table: SRAM stack, reset handler in the image */
+  vectors = (const uint32_t *)(DFU_STAGE_ADDR + 0x100);
+  if (len > DFU_STAGE_OFFSET || len < 0x100 + 8 ||
+      (vectors[0] & 0xfff00000) != 0x20000000 ||
+      vectors[1] < XIP_BASE + 0x100 || vectors[1] >= XIP_BASE + len || !(vectors[1] & 1)) {
+    dfu_result = "not an RP2040 firmware image";
+    return DFU_STATUS_ERR_FIRMWARE;
+  }
+  if (crc32((const uint8_t *)DFU_STAGE_ADDR, len) != t->crc) {
+    dfu_result = "CRC error";
+    return DFU_STATUS_ERR_VERIFY;
+  }
+  dfu_length = len;
+  dfu_result = "verified, rebooting";
+  return DFU_STATUS_OK;
+}
+
+/*
+ * TinyUSB DFU callbacks, USB device task
+ */
+uint32_t tud_dfu_get_timeout_cb(uint8_t alt, uint8_t state)
+{
+  (void) alt;
+  /* The next GETSTATUS is served once the block is written anyway */
+  return (state == DFU_MANIFEST) ? 100 : 1;
+}
+
+void tud_dfu_download_cb(uint8_t alt, uint16_t block_num, uint8_t const *data, uint16_t length)
+{
+  const uint32_t offs = block_num * CFG_TUD_DFU_XFER_BUFSIZE;
+  uint32_t len = length;
+
+  (void) alt;
+  if (block_num == 0) {
+    dfu_received = 0;
+    dfu_erased = 0;
+    dfu_result = "download in progress";
+  }
+  if ((uint32_t)&__flash_binary_end - XIP_BASE > DFU_STAGE_OFFSET) {
+    dfu_result = "running firmware overlaps the staging area";
+    tud_dfu_finish_flashing(DFU_STATUS_ERR_TARGET);
+    return;
+  }
+  if (offs + len > DFU_STAGE_SIZE) {
+    dfu_result = "image is too large";
+    tud_dfu_finish_flashing(DFU_STATUS_ERR_ADDRESS);
+    return;
+  }
+
+  for (uint32_t b = offs / DFU_ERASE_SIZE; b <= (offs + len - 1) / DFU_ERASE_SIZE; b++) {
+    if (!(dfu_erased & (1u << b))) {
+      dfu_flash_erase(DFU_STAGE_OFFSET + b * DFU_ERASE_SIZE, DFU_ERASE_SIZE);
+      dfu_erased |= 1u << b;
+    }
+  }
+  if (len % FLASH_PAGE_SIZE) {
+    memcpy(dfu_buf, data, len);
+    memset(dfu_buf + len, 0xff, FLASH_PAGE_SIZE - len % FLASH_PAGE_SIZE);
+    data = dfu_buf;
+    len += FLASH_PAGE_SIZE - len % FLASH_PAGE_SIZE;
+  }
+  dfu_flash_program(DFU_STAGE_OFFSET + offs, data, len);
+  dfu_received = MAX(dfu_received, offs + length);
+
+  tud_dfu_finish_flashing(DFU_STATUS_OK);
+}
+
+void tud_dfu_manifest_cb(uint8_t alt)
+{
+  uint8_t status;
+
+  (void) alt;
+  status = dfu_verify();
+  tud_dfu_finish_flashing(status);
+  if (status == DFU_STATUS_OK) xTaskNotifyGive(dfu_task_handle);
+}
+
+void tud_dfu_abort_cb(uint8_t alt)
+{
+  (void) alt;
+  dfu_result = "download aborted";
+}
+
+static BaseType_t cli_dfu(char *pcWriteBuffer,
+                          size_t xWriteBufferLen,
+                          const char *pcCmd)
+{
+  snprintf(pcWriteBuffer, xWriteBufferLen,
+           "Firmware %lu bytes, staging area %luK at 0x%08lx\n"
+           "Last update: %s, %lu bytes received\n",
+           (unsigned long)((uint32_t)&__flash_binary_end - XIP_BASE),
+           (unsigned long)(DFU_STAGE_SIZE / 1024), (unsigned long)DFU_STAGE_ADDR,
+           dfu_result, (unsigned long)dfu_received);
+  return pdFALSE;
+}
+
+static const CLI_Command_Definition_t dfu_cmd = {
+  "dfu",
+  "dfu\n"
+  "  Status of the firmware update over USB DFU (dfu-util)\n\n",
+  cli_dfu,
+  0
+};
+
+void cli_register_dfu(void)
+{
+  FreeRTOS_CLIRegisterCommand(&dfu_cmd);
+}
+
+void gmm7550_dfu_init(void)
+{
+  xTaskCreate(dfu_task, "DFU",
+              configMINIMAL_STACK_SIZE,
+              NULL,
+              (tskIDLE_PRIORITY + 1UL),
+              &dfu_task_handle
+              );
+}
@@ -1,6 +1,7 @@
 #include "pico/stdlib.h"
 #include "gmm7550_control.h"
 #include "FreeRTOS_CLI.h"
+#include "chain.h"
 
 static void gmm7550_gpio_init(void)
 {
@@ -16,19 +17,31 @@ static void gmm7550_gpio_init(void)
   gpio_put(GMM7550_MR_PIN, 1);
 }
 
+/* The cached scan chain is dropped whenever the FPGA may change it */
+
 void gmm7550_on(void)
 {
   gpio_put(GMM7550_EN_PIN, 1);
+  jtag_chain_invalidate();
 }
 
-static void gmm7550_off(void)
+void gmm7550_off(void)
 {
   gpio_put(GMM7550_EN_PIN, 0);
   i2c_gpio_initialized = false;
+  jtag_chain_invalidate();
+}
+
+/* Module is powered on and out of the hard reset: I2C expander and SPI
+ * Mux can be used */
+bool gmm7550_is_ready(void)
+{
+  return gpio_get_out_level(GMM7550_EN_PIN) && !gpio_get_out_level(GMM7550_MR_PIN);
 }
 
 void gmm7550_hreset(uint rst)
 {
+  jtag_chain_invalidate();
   switch (rst) {
   case 0:  /* deassert */
     gpio_put(GMM7550_MR_PIN, 0);
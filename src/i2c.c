@@ -4,14 +4,32 @@
 
 #include "string.h"
 #include "hex.h"
+#include "semphr.h"
+#include "chain.h"
 
 #define PCA9539A_ADDR 0x74
 
 i2c_inst_t *i2c = I2C_INSTANCE(GMM7550_I2C);
 bool i2c_gpio_initialized = false;
 
-static void gmm7550_i2c_init(void)
+/* The bus is shared by the CLI, USB board requests, bitstream loader
+ * and mass storage engine.  Recursive: read-modify-write sequences
+ * hold it around pca_read_reg()/pca_write_reg() */
+static SemaphoreHandle_t i2c_mutex;
+
+void gmm7550_i2c_acquire(void)
+{
+  xSemaphoreTakeRecursive(i2c_mutex, portMAX_DELAY);
+}
+
+void gmm7550_i2c_release(void)
 {
+  xSemaphoreGiveRecursive(i2c_mutex);
+}
+
+void gmm7550_i2c_init(void)
+{
+  i2c_mutex = xSemaphoreCreateRecursiveMutex();
   i2c_init(i2c, 400000);
   gpio_pull_up(GMM7550_I2C_SDA_PIN);
   gpio_pull_up(GMM7550_I2C_SCL_PIN);
@@ -24,7 +42,9 @@ void pca_write_reg(const uint8_t reg, const uint8_t data)
   uint8_t buf[2];
   buf[0] = reg;
   buf[1] = data;
+  gmm7550_i2c_acquire();
   (void) i2c_write_blocking(i2c, PCA9539A_ADDR, buf, 2, false);
+  gmm7550_i2c_release();
 }
 
 uint8_t pca_read_reg(const uint8_t reg)
@@ -32,9 +52,11 @@ uint8_t pca_read_reg(const uint8_t reg)
   uint8_t tx = reg;
   uint8_t rx = 0;
 
+  gmm7550_i2c_acquire();
   if (i2c_write_blocking(i2c, PCA9539A_ADDR, &tx, 1, true) == 1) {
     (void) i2c_read_blocking(i2c, PCA9539A_ADDR, &rx, 1, false);
   }
+  gmm7550_i2c_release();
   return rx;
 }
 
@@ -51,6 +73,7 @@ static bool config_is_safe(uint8_t b)
 
 void gmm7550_i2c_gpio_init(void)
 {
+  gmm7550_i2c_acquire();
   if (!i2c_gpio_initialized) {
     /* output port 0 */
     /* hardware default values */
@@ -73,6 +96,7 @@ void gmm7550_i2c_gpio_init(void)
 
     i2c_gpio_initialized = true;
   }
+  gmm7550_i2c_release();
 }
 
 static BaseType_t cli_i2c_scan(char *pcWriteBuffer,
@@ -80,6 +104,7 @@ static BaseType_t cli_i2c_scan(char *pcWriteBuffer,
                                const char *pcCmd)
 {
   static uint line = 0;
+  int ret;
   char *p;
   uint8_t addr, byte;
 
@@ -96,7 +121,10 @@ static BaseType_t cli_i2c_scan(char *pcWriteBuffer,
     *p++ = ' ';
     for (int i=0; i<0x10; i++) {
       addr = (((line-1) << 4) + i);
-      if (i2c_write_blocking(i2c, addr, &byte, 1, false) < 0) {
+      gmm7550_i2c_acquire();
+      ret = i2c_write_blocking(i2c, addr, &byte, 1, false);
+      gmm7550_i2c_release();
+      if (ret < 0) {
         *p++ = '-';
         *p++ = '-';
       } else {
@@ -148,6 +176,7 @@ static BaseType_t cli_pca(char *pcWriteBuffer,
     *p++ = ' ';
 
     wr_byte = line - 1; /* register index */
+    gmm7550_i2c_acquire();
     if (i2c_write_blocking(i2c, PCA9539A_ADDR, &wr_byte, 1, true) == 1) {
       if (i2c_read_blocking(i2c, PCA9539A_ADDR, &rd_byte, 1, false) == 1) {
         *p++ = hex_digit(rd_byte >> 4);
@@ -160,6 +189,7 @@ static BaseType_t cli_pca(char *pcWriteBuffer,
       *p++ = '-';
       *p++ = 'w';
     }
+    gmm7550_i2c_release();
 
     *p++ = '\n';
     *p++ = '\0';
@@ -184,6 +214,7 @@ void gmm7550_sreset(const uint rst)
 {
   uint8_t data;
 
+  gmm7550_i2c_acquire();
   if (!i2c_gpio_initialized) {gmm7550_i2c_gpio_init();}
 
   switch (rst) {
@@ -203,6 +234,50 @@ void gmm7550_sreset(const uint rst)
     vTaskDelay(GMM7550_MR_TIME_MS / portTICK_PERIOD_MS);
     pca_write_reg(2, data |  0x01);
   }
+  gmm7550_i2c_release();
+}
+
+/* Change SPI Mux (mask 0xf0) or Configuration Mode (mask 0x0f) bits
+ * of the output port 1, FPGA is held in reset meanwhile */
+static bool gmm7550_set_port1(const uint8_t mask, const uint8_t bits)
+{
+  uint8_t srst;
+  uint8_t data;
+
+  gmm7550_i2c_acquire();
+  if (!i2c_gpio_initialized) {gmm7550_i2c_gpio_init();}
+
+  data = pca_read_reg(3); /* output port 1 */
+  data &= ~mask; /* keep the other settings */
+  data |= bits & mask;
+
+  if (!config_is_safe(data)) {
+    gmm7550_i2c_release();
+    return false;
+  }
+
+  srst = pca_read_reg(2) & 0x01; /* save state of the reset signal */
+  gmm7550_sreset(1);      /* assert reset signal to the FPGA */
+
+  pca_write_reg(3, data); /* set new SPI Mux/Configuration Mode */
+  vTaskDelay(GMM7550_MR_TIME_MS / portTICK_PERIOD_MS);
+
+  data = pca_read_reg(2); /* reset bit is known to be 0 (reset active) at this point */
+  data |= srst;           /* restore reset state */
+  pca_write_reg(2, data);
+  gmm7550_i2c_release();
+  return true;
+}
+
+bool gmm7550_set_mux(const uint8_t mux)
+{
+  return gmm7550_set_port1(0xf0, mux << 4);
+}
+
+bool gmm7550_set_cfg(const uint8_t cfg)
+{
+  jtag_chain_invalidate();
+  return gmm7550_set_port1(0x0f, cfg);
 }
 
 static BaseType_t cli_mux(char *pcWriteBuffer,
@@ -210,9 +285,7 @@ static BaseType_t cli_mux(char *pcWriteBuffer,
                           const char *pcCmd)
 {
   BaseType_t p_len;
-  uint8_t srst;
   uint8_t mux;
-  uint8_t data;
 
   char *p = (char *)FreeRTOS_CLIGetParameter(pcCmd, 1, &p_len);
 
@@ -220,23 +293,7 @@ static BaseType_t cli_mux(char *pcWriteBuffer,
 
     mux = char2hex(*p);
 
-    if (!i2c_gpio_initialized) {gmm7550_i2c_gpio_init();}
-
-    data = pca_read_reg(3); /* output port 1 */
-    data &= 0x0f; /* keep configuration mode settings */
-    data |= mux << 4;
-
-    if (config_is_safe(data)) {
-      srst = pca_read_reg(2) & 0x01; /* save state of the reset signal */
-      gmm7550_sreset(1);      /* assert reset signal to the FPGA */
-
-      pca_write_reg(3, data); /* set new SPI Mux/Configuration Mode */
-      vTaskDelay(GMM7550_MR_TIME_MS / portTICK_PERIOD_MS);
-
-      data = pca_read_reg(2); /* reset bit is known to be 0 (reset active) at this point */
-      data |= srst;           /* restore reset state */
-      pca_write_reg(2, data);
-
+    if (gmm7550_set_mux(mux)) {
       p = stpncpy(pcWriteBuffer, "SPI Mux configuration is ", xWriteBufferLen);
       *p++ = hex_digit(mux);
       *p++ = '\n';
@@ -262,9 +319,7 @@ static BaseType_t cli_cfg(char *pcWriteBuffer,
                           const char *pcCmd)
 {
   BaseType_t p_len;
-  uint8_t srst;
   uint8_t cfg;
-  uint8_t data;
 
   char *p = (char *)FreeRTOS_CLIGetParameter(pcCmd, 1, &p_len);
 
@@ -272,23 +327,7 @@ static BaseType_t cli_cfg(char *pcWriteBuffer,
 
     cfg = char2hex(*p);
 
-    if (!i2c_gpio_initialized) {gmm7550_i2c_gpio_init();}
-
-    data = pca_read_reg(3); /* output port 1 */
-    data &= 0xf0; /* keep SPI multiplexor settings */
-    data |= cfg;
-
-    if (config_is_safe(data)) {
-      srst = pca_read_reg(2) & 0x01; /* save state of the reset signal */
-      gmm7550_sreset(1);      /* assert reset signal to the FPGA */
-
-      pca_write_reg(3, data); /* set new SPI Mux/Configuration Mode */
-      vTaskDelay(GMM7550_MR_TIME_MS / portTICK_PERIOD_MS);
-
-      data = pca_read_reg(2); /* reset bit is known to be 0 (reset active) at this point */
-      data |= srst;           /* restore reset state */
-      pca_write_reg(2, data);
-
+    if (gmm7550_set_cfg(cfg)) {
       p = stpncpy(pcWriteBuffer, "Configuration mode is ", xWriteBufferLen);
       *p++ = hex_digit(cfg);
       *p++ = '\n';
@@ -342,7 +381,6 @@ static const CLI_Command_Definition_t rst_cmd = {
 
 void cli_register_i2c(void)
 {
-  gmm7550_i2c_init();
   FreeRTOS_CLIRegisterCommand(&scan_cmd);
   FreeRTOS_CLIRegisterCommand(&pca_cmd);
   FreeRTOS_CLIRegisterCommand(&mux_cmd);
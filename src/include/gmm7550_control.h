@@ -38,8 +38,71 @@ extern int  serial_getc_us(void);
 #define CDC_SERIAL 0
 #define CDC_CLI    1
 #define CDC_SPI    2
+#define CDC_JTAG   3
+#define CDC_XVC    4
+#define CDC_PIPE   5
 
 extern void usb_task(void *params);
+/* Vendor control requests of the device (any recipient), bRequest
+ * 0x00..0x0c and 0x90..0x92 are taken by the FTDI requests (mpsse.c) */
+#define GMM7550_VREQ_USBSTAT 0x20 /* IN: traffic counters (usbstat.c) */
+#define GMM7550_VREQ_BENCH   0x21 /* OUT: set mode (wValue), IN: counters (jtag.c) */
+#define GMM7550_VREQ_PROFILE 0x22 /* IN: USB buffer profile, query or switch (profile.c) */
+/* Board control, IN requests with the argument in wValue, all of them
+ * reply with 4 bytes: status, state flags, SPI Mux/Configuration Mode
+ * (PCA9539A output port 1), 0 */
+#define GMM7550_VREQ_STATE   0x30 /* no argument */
+#define GMM7550_VREQ_POWER   0x31 /* 0 -- off, 1 -- on (as 'off' and 'on') */
+#define GMM7550_VREQ_HRESET  0x32 /* 0 -- deassert, 1 -- assert, 2 -- pulse */
+#define GMM7550_VREQ_SRESET  0x33 /* 0 -- deassert, 1 -- assert, 2 -- pulse */
+#define GMM7550_VREQ_MUX     0x34 /* SPI Mux, 0..f */
+#define GMM7550_VREQ_CFG     0x35 /* Configuration Mode, 0..f */
+/* status */
+#define GMM7550_VREQ_OK      0
+#define GMM7550_VREQ_EINVAL  1 /* bad argument */
+#define GMM7550_VREQ_EUNSAFE 2 /* unsafe SPI Mux and Configuration Mode combination */
+#define GMM7550_VREQ_EOFF    3 /* module is off or in hard reset */
+/* state flags */
+#define GMM7550_STATE_ON     0x01 /* power enabled */
+#define GMM7550_STATE_HRESET 0x02 /* hard reset asserted */
+#define GMM7550_STATE_SRESET 0x04 /* soft reset asserted */
+#define GMM7550_STATE_I2C    0x08 /* I2C GPIO initialized, Mux/Mode is valid */
+
+/* usb_descriptors.c */
+/* OUT and IN data endpoints of an interface */
+typedef struct {
+  const char *name;
+  uint8_t ep_out;
+  uint8_t ep_in;
+} usb_channel_t;
+#define USB_CHANNEL_PROBE  0
+#define USB_CHANNEL_CDC(n) (1 + (n))
+extern const usb_channel_t usb_channels[];
+extern const uint usb_n_channels;
+
+/* profile.c */
+/* Deep buffers of the channels, carved out of one pool at boot */
+typedef struct {
+  const char *name;
+  const char *descr;
+  uint16_t djtag_depth;         /* DirtyJTAG command queue, 64-byte packets */
+  uint16_t cdc_rx[CFG_TUD_CDC]; /* CDC rings, power of two, 0 -- FIFO only */
+  uint16_t cdc_tx[CFG_TUD_CDC];
+} usb_profile_t;
+extern const usb_profile_t *usb_profile;
+extern void usb_profile_init(void);
+extern void *usb_profile_alloc(size_t size);
+extern bool profile_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_request_t const *request);
+extern void cli_register_profile(void);
+
+/* cdcbuf.c */
+extern void cdcbuf_init(void);
+extern void cdcbuf_clear(uint8_t itf);
+
+/* usbstat.c */
+extern void usbstat_full(uint8_t ep_addr);
+extern bool usbstat_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_request_t const *request);
+extern void cli_register_usbstat(void);
 
 /* cli.c */
 extern void cli_task(void *params);
@@ -53,17 +116,24 @@ extern volatile bool cli_was_connected;
 
 #define GMM7550_MR_TIME_MS 10
 extern void cli_register_gpio(void);
-/* Exports for auto-start function */
+/* Exports for auto-start function and vendor requests */
 extern void gmm7550_on(void);
+extern void gmm7550_off(void);
 extern void gmm7550_hreset(uint rst);
+extern bool gmm7550_is_ready(void);
 
 /* i2c.c */
 #define GMM7550_I2C         1
 #define GMM7550_I2C_SDA_PIN 2
 #define GMM7550_I2C_SCL_PIN 3
 
+extern void gmm7550_i2c_init(void);
 extern void cli_register_i2c(void);
 extern bool i2c_gpio_initialized;
+/* Exclusive access to the I2C bus, may be nested; pca_read_reg() and
+ * pca_write_reg() take it, hold it across read-modify-write sequences */
+extern void gmm7550_i2c_acquire(void);
+extern void gmm7550_i2c_release(void);
 /* Exports for PLL (CDCE6214) control and programming */
 #include "hardware/i2c.h"
 extern i2c_inst_t *i2c;
@@ -72,6 +142,9 @@ extern void pca_write_reg(const uint8_t r, const uint8_t d);
 extern uint8_t pca_read_reg(const uint8_t r);
 /* Exports for auto-start function */
 extern void gmm7550_i2c_gpio_init(void);
+/* SPI Mux / Configuration Mode, false if the combination is unsafe */
+extern bool gmm7550_set_mux(const uint8_t mux);
+extern bool gmm7550_set_cfg(const uint8_t cfg);
 
 /* pll.c */
 extern void cli_register_pll(void);
@@ -85,6 +158,13 @@ extern void cli_register_pll(void);
 extern void gmm7550_spi_init(void);
 extern void gmm7550_spi_set_baudrate(const uint rate);
 extern void gmm7550_spi_set_cs(const bool cs);
+extern void gmm7550_spi_bridge_cs(const bool cs);
+/* Exports for the mass storage engine */
+extern bool gmm7550_spi_acquire(void);
+extern void gmm7550_spi_release(void);
+extern void gmm7550_spi_wait(void);
+extern void gmm7550_spi_write_dma(const uint8_t *buf, const uint len);
+extern void gmm7550_spi_transfer(const uint8_t *tx, uint8_t *rx, const uint len);
 extern volatile bool spi_connected;
 
 /* adc.c */
@@ -100,6 +180,60 @@ extern void cli_register_adc(void);
 #define GMM7550_JTAG_TCK_PIN 17
 #define GMM7550_JTAG_TDO_PIN 18
 #define GMM7550_JTAG_TMS_PIN 19
+/* DirtyJTAG command queue, 64-byte packets (default USB buffer profile) */
+#ifndef GMM7550_DJTAG_QUEUE_DEPTH
+#define GMM7550_DJTAG_QUEUE_DEPTH 8
+#endif
+extern const uint djtag_buffer_size; /* per queued packet */
 extern void gmm7550_jtag_init(void);
+extern void cli_register_jtag(void);
+/* Exclusive access to the JTAG engine (pio_jtag_inst_t) */
+struct pio_jtag_inst;
+extern struct pio_jtag_inst *gmm7550_jtag_acquire(void);
+extern void gmm7550_jtag_release(void);
+/* Same for the JTAG pipe, NULL while another user has been active recently */
+extern struct pio_jtag_inst *gmm7550_jtag_acquire_background(void);
+extern void gmm7550_jtag_release_background(void);
+/* DirtyJTAG vendor interface class driver, registered in usb.c */
+extern void djtag_itf_init(void);
+extern void djtag_itf_reset(uint8_t rhport);
+extern uint16_t djtag_itf_open(uint8_t rhport, tusb_desc_interface_t const *itf_desc, uint16_t max_len);
+extern bool djtag_itf_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_request_t const *request);
+extern bool djtag_itf_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes);
+/* USB link benchmark modes of the DirtyJTAG interface */
+#define DJTAG_BENCH_OFF    0 /* DirtyJTAG commands */
+#define DJTAG_BENCH_ECHO   1 /* OUT packets are sent back */
+#define DJTAG_BENCH_SOURCE 2 /* IN endpoint sends endless data */
+#define DJTAG_BENCH_SINK   3 /* OUT packets are dropped */
+extern bool djtag_bench_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_request_t const *request);
+
+/* svf.c */
+/* The host has stopped in the middle of an SVF file or a bitstream, the
+ * JTAG engine is given back to the other channels (svf.c, jcfg.c) */
+#define SVF_INPUT_TIMEOUT_MS 5000
+extern void gmm7550_svf_init(void);
+
+/* jcfg.c */
+#define JCFG_SOH 0x01 /* starts a bitstream on the JTAG CDC channel */
+extern void gmm7550_jcfg_load(const struct pio_jtag_inst *jtag);
+
+/* xvc.c */
+extern void gmm7550_xvc_init(void);
+
+/* jpipe.c */
+extern void gmm7550_jpipe_init(void);
+extern void cli_register_jpipe(void);
+
+/* mpsse.c */
+extern void gmm7550_mpsse_init(void);
+extern bool mpsse_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_request_t const *request);
+
+/* msc.c */
+extern void gmm7550_msc_init(void);
+extern void cli_register_msc(void);
+
+/* dfu.c */
+extern void gmm7550_dfu_init(void);
+extern void cli_register_dfu(void);
 
 #endif
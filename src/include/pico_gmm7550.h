@@ -14,6 +14,16 @@ pico_board_cmake_set(PICO_PLATFORM, rp2040)
 
 #define PICO_BOOT_STAGE2_CHOOSE_GENERIC_03H 1
 
+/* Optional 200 MHz clk_sys (cmake -DGMM7550_SYS_CLK_BOOST=ON) for
+ * JTAG TCK above 20 MHz.  Flash SPI clock is kept at 50 MHz.
+ */
+#if GMM7550_SYS_CLK_BOOST
+#define GMM7550_SYS_CLK_KHZ 200000
+#ifndef PICO_FLASH_SPI_CLKDIV
+#define PICO_FLASH_SPI_CLKDIV 4
+#endif
+#endif
+
 #ifndef PICO_FLASH_SPI_CLKDIV
 #define PICO_FLASH_SPI_CLKDIV 2
 #endif
@@ -104,11 +104,24 @@
 #endif
 
 //------------- CLASS -------------//
-#define CFG_TUD_CDC              3
+#define CFG_TUD_CDC              6
+#if GMM7550_MSC
+#define CFG_TUD_MSC              1 /* drag-and-drop configuration and NOR programming (msc.c) */
+#else
 #define CFG_TUD_MSC              0
+#endif
+#if GMM7550_DFU
+#define CFG_TUD_DFU              1 /* firmware update with dfu-util (dfu.c) */
+#else
+#define CFG_TUD_DFU              0
+#endif
 #define CFG_TUD_HID              0
 #define CFG_TUD_MIDI             0
-#define CFG_TUD_VENDOR           1
+#if GMM7550_MPSSE
+#define CFG_TUD_VENDOR           1 /* FTDI MPSSE emulation (mpsse.c), DirtyJTAG has its own class driver (jtag.c) */
+#else
+#define CFG_TUD_VENDOR           0 /* DirtyJTAG has its own class driver (jtag.c) */
+#endif
 
 // CDC FIFO size of TX and RX
 #define CFG_TUD_CDC_RX_BUFSIZE   (TUD_OPT_HIGH_SPEED ? 512 : 64)
@@ -117,9 +130,21 @@
 // CDC Endpoint transfer buffer size, more is faster
 #define CFG_TUD_CDC_EP_BUFSIZE   (TUD_OPT_HIGH_SPEED ? 512 : 64)
 
-// Vendor class interface for DirtyJTAG
-#define CFG_TUD_VENDOR_RX_BUFSIZE 128
-#define CFG_TUD_VENDOR_TX_BUFSIZE 64
+#if GMM7550_MSC
+// MSC buffer, one 512-byte block per read/write callback
+#define CFG_TUD_MSC_EP_BUFSIZE   512
+#endif
+
+#if GMM7550_DFU
+// DFU download block, one flash sector
+#define CFG_TUD_DFU_XFER_BUFSIZE 4096
+#endif
+
+#if GMM7550_MPSSE
+// Vendor FIFO size of TX and RX
+#define CFG_TUD_VENDOR_RX_BUFSIZE 512
+#define CFG_TUD_VENDOR_TX_BUFSIZE 512
+#endif
 
 #ifdef __cplusplus
  }
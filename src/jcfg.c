@@ -0,0 +1,166 @@
+/*
+ * Raspberry Pi RP2040 Control firmware for GMM-7550 module
+ * https://www.gmm7550.dev/doc/rp2040.html
+ *
+ * Copyright (c) 2026 Anton Kuzmin <ak@gmm7550.dev>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* GateMate FPGA configuration via JTAG
+ *
+ * Bitstream is sent by the host over the JTAG CDC channel (the same
+ * one as SVF files).  The load starts with SOH character (0x01), which
+ * cannot start an SVF file, then bitstream length in bytes (32 bit,
+ * little endian) and the raw bitstream (.bit file) follow.
+ *
+ * The firmware resets the FPGA, loads the CONFIGURE instruction and
+ * streams the whole bitstream through the PIO in a single DR scan,
+ * then waits for CFG_DONE and replies with a single line:
+ *   PASS <number of bytes>   configuration done
+ *   FAIL <number of bytes>   CFG_FAILED, or no CFG_DONE in time
+ *   ERROR <number of bytes>  not in JTAG configuration mode (cfg c),
+ *                            bad length (0 or not below 512 MiB),
+ *                            or the host has gone in the middle (or
+ *                            sent nothing for SVF_INPUT_TIMEOUT_MS),
+ *                            the number of bytes received then
+ */
+
+#include "pico/stdlib.h"
+#include "gmm7550_control.h"
+#include "tusb.h"
+#include "pio_jtag.h"
+#include "tap.h"
+#include "chain.h"
+
+#define JCFG_IR_LEN          6
+#define JCFG_BLOCK_SIZE      1024
+#define JCFG_STARTUP_CYCLES  100
+#define JCFG_DONE_TIMEOUT_MS 1000
+/* The DR scan length in bits is 32-bit (pio_jtag_stream_start()) */
+#define JCFG_MAX_LEN         (UINT32_MAX / 8)
+
+/* PCA9539A port 0 inputs, CFG_FAILED_N is inverted by the polarity register */
+#define PCA_CFG_FAILED 0x04
+#define PCA_CFG_DONE   0x08
+
+/* Configuration mode (PCA9539A port 1, bits 3..0) */
+#define PCA_CFG_MODE_JTAG 0x0c
+
+/* CONFIGURE instruction (0x06), first shifted bit is the MSB */
+static const uint8_t jcfg_ir_configure[] = {0x60};
+
+static uint8_t jcfg_buf[JCFG_BLOCK_SIZE];
+
+/* Returns number of bytes read, less than len if the host has gone */
+static uint32_t jcfg_read(uint8_t *buf, uint32_t len)
+{
+  TickType_t t_last = xTaskGetTickCount();
+  uint32_t done = 0;
+
+  while (done < len) {
+    if (!tud_cdc_n_connected(CDC_JTAG)) break;
+    if (tud_cdc_n_available(CDC_JTAG)) {
+      done += tud_cdc_n_read(CDC_JTAG, buf + done, len - done);
+      t_last = xTaskGetTickCount();
+    } else if (xTaskGetTickCount() - t_last > pdMS_TO_TICKS(SVF_INPUT_TIMEOUT_MS)) {
+      break;
+    } else {
+      vTaskDelay(1);
+    }
+  }
+  return done;
+}
+
+static void jcfg_skip(uint32_t len)
+{
+  uint32_t n;
+
+  while (len) {
+    n = MIN(len, sizeof(jcfg_buf));
+    if (jcfg_read(jcfg_buf, n) < n) return;
+    len -= n;
+  }
+}
+
+static void jcfg_reply(const char *result, uint32_t n)
+{
+  char line[24];
+
+  snprintf(line, sizeof(line), "%s %lu\n", result, (unsigned long)n);
+  tud_cdc_n_write_str(CDC_JTAG, line);
+  tud_cdc_n_write_flush(CDC_JTAG);
+}
+
+/* Returns number of bytes received from the host.  If the host has
+ * gone, the DR scan is abandoned and the TAP is reset */
+static uint32_t jcfg_stream(const pio_jtag_inst_t *jtag, uint32_t len)
+{
+  uint32_t done = 0, n, got;
+
+  tap_goto(jtag, TAP_DRSHIFT);
+  pio_jtag_stream_start(jtag, len * 8);
+  while (done < len) {
+    n = MIN(len - done, sizeof(jcfg_buf));
+    got = jcfg_read(jcfg_buf, n);
+    if (got < n) {
+      pio_jtag_stream_abort(jtag);
+      tap_invalidate();
+      tap_reset(jtag);
+      return done + got;
+    }
+    pio_jtag_stream_write_read(jtag, jcfg_buf, NULL, n);
+    done += n;
+  }
+  return len;
+}
+
+static bool jcfg_wait_done(void)
+{
+  uint8_t st = 0;
+
+  for (int t = 0; t < JCFG_DONE_TIMEOUT_MS; t++) {
+    st = pca_read_reg(0);
+    if (st & (PCA_CFG_DONE | PCA_CFG_FAILED)) break;
+    vTaskDelay(1 / portTICK_PERIOD_MS);
+  }
+  return (st & PCA_CFG_DONE) && !(st & PCA_CFG_FAILED);
+}
+
+void gmm7550_jcfg_load(const pio_jtag_inst_t *jtag)
+{
+  uint8_t hdr[5];
+  uint32_t len, n;
+
+  if (jcfg_read(hdr, sizeof(hdr)) < sizeof(hdr)) return;
+  len = hdr[1] | (hdr[2] << 8) | (hdr[3] << 16) | ((uint32_t)hdr[4] << 24);
+
+  if (len == 0 || len > JCFG_MAX_LEN) {
+    jcfg_skip(len);
+    jcfg_reply("ERROR", 0);
+    return;
+  }
+
+  if (!i2c_gpio_initialized) {gmm7550_i2c_gpio_init();}
+
+  if ((pca_read_reg(3) & 0x0f) != PCA_CFG_MODE_JTAG) {
+    jcfg_skip(len);
+    jcfg_reply("ERROR", 0);
+    return;
+  }
+
+  gmm7550_sreset(2); /* start from the clean configuration state */
+
+  tap_invalidate();
+  tap_shift(jtag, true, jcfg_ir_configure, NULL, JCFG_IR_LEN, TAP_IDLE);
+  n = jcfg_stream(jtag, len);
+  jtag_chain_invalidate(); /* the design may add its own TAPs */
+  if (n < len) {
+    jcfg_reply("ERROR", n);
+    return;
+  }
+
+  tap_goto(jtag, TAP_IDLE);
+  tap_run(jtag, JCFG_STARTUP_CYCLES);
+  jcfg_reply(jcfg_wait_done() ? "PASS" : "FAIL", n);
+}
@@ -0,0 +1,231 @@
+/*
+ * Raspberry Pi RP2040 Control firmware for GMM-7550 module
+ * https://www.gmm7550.dev/doc/rp2040.html
+ *
+ * Copyright (c) 2026 Anton Kuzmin <ak@gmm7550.dev>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* JTAG pipe -- byte stream between the pipe CDC channel and the FPGA
+ * user logic behind a USER JTAG instruction.
+ *
+ * The USER instruction (and IR length, if the chain scan does not
+ * know it) is set with 'pipe' CLI command, the FPGA is expected to be
+ * the only device in the chain.  Data are exchanged by back-to-back
+ * DR scans of a fixed frame, at the maximal TCK frequency (the
+ * previous frequency is restored when the pipe releases JTAG).  The
+ * pipe is parked while another JTAG client (DirtyJTAG, SVF, XVC, ...)
+ * is active and for a second after it, see jtag.c.
+ *
+ * Frame is JPIPE_FRAME_BYTES long, LSB of byte 0 is shifted first:
+ *   byte 0      header
+ *     bit 7     READY: receiver of this frame will accept a full
+ *               payload in the next frame (TDI), or accepts the
+ *               payload of this frame (TDO, as captured)
+ *     bits 5..0 number of valid payload bytes (0..JPIPE_PAYLOAD)
+ *   bytes 1..   payload
+ * The firmware keeps the payload until it is accepted by the FPGA
+ * (READY in TDO header), and FPGA may send payload only if READY was
+ * set in TDI header of the previous frame.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "gmm7550_control.h"
+#include "FreeRTOS_CLI.h"
+#include "tusb.h"
+#include "pio_jtag.h"
+#include "tap.h"
+#include "chain.h"
+
+#define JPIPE_PAYLOAD     32
+#define JPIPE_FRAME_BYTES (1 + JPIPE_PAYLOAD)
+#define JPIPE_READY       0x80
+#define JPIPE_COUNT       0x3f
+
+#define JPIPE_TCK_KHZ     100000 /* as fast as the PIO can go */
+#define JPIPE_BURST       64     /* frames per JTAG lock */
+#define JPIPE_IN_SIZE     256    /* FPGA -> host buffer */
+
+static uint32_t jpipe_ir;
+static uint8_t jpipe_ir_len; /* 0 -- pipe is off */
+
+/* one spare byte for the PIO readback */
+static uint8_t jpipe_tdi[JPIPE_FRAME_BYTES + 1];
+static uint8_t jpipe_tdo[JPIPE_FRAME_BYTES + 1];
+
+static uint8_t jpipe_out[JPIPE_PAYLOAD]; /* host -> FPGA, until accepted */
+static uint jpipe_out_len;
+static uint8_t jpipe_in[JPIPE_IN_SIZE];  /* FPGA -> host */
+static uint jpipe_in_len;
+
+static struct {
+  uint32_t frames;
+  uint32_t to_fpga;
+  uint32_t from_fpga;
+  uint32_t dropped;
+} jpipe_stat;
+
+static void jpipe_select(const pio_jtag_inst_t *jtag)
+{
+  uint8_t ir[4];
+
+  for (uint i = 0; i < sizeof(ir); i++) {
+    ir[i] = jtag_rev8(jpipe_ir >> (8 * i));
+  }
+  tap_shift(jtag, true, ir, NULL, jpipe_ir_len, TAP_IDLE);
+}
+
+static void jpipe_flush(void)
+{
+  uint32_t n;
+
+  if (jpipe_in_len == 0) return;
+  n = tud_cdc_n_write(CDC_PIPE, jpipe_in, jpipe_in_len);
+  if (n) {
+    memmove(jpipe_in, jpipe_in + n, jpipe_in_len - n);
+    jpipe_in_len -= n;
+    tud_cdc_n_write_flush(CDC_PIPE);
+  }
+}
+
+/* Returns true if any data have been moved */
+static bool jpipe_frame(const pio_jtag_inst_t *jtag)
+{
+  bool room = (sizeof(jpipe_in) - jpipe_in_len) >= 2 * JPIPE_PAYLOAD;
+  uint8_t hdr;
+  uint n;
+
+  if (jpipe_out_len == 0 && tud_cdc_n_available(CDC_PIPE)) {
+    jpipe_out_len = tud_cdc_n_read(CDC_PIPE, jpipe_out, sizeof(jpipe_out));
+  }
+
+  jpipe_tdi[0] = jtag_rev8(jpipe_out_len | (room ? JPIPE_READY : 0));
+  for (uint i = 0; i < jpipe_out_len; i++) {
+    jpipe_tdi[1 + i] = jtag_rev8(jpipe_out[i]);
+  }
+  tap_shift(jtag, false, jpipe_tdi, jpipe_tdo, JPIPE_FRAME_BYTES * 8, TAP_IDLE);
+  jpipe_stat.frames++;
+
+  hdr = jtag_rev8(jpipe_tdo[0]);
+  n = MIN(hdr & JPIPE_COUNT, JPIPE_PAYLOAD);
+  if (n > sizeof(jpipe_in) - jpipe_in_len) {
+    /* FPGA has sent more than allowed */
+    jpipe_stat.dropped += n;
+    n = 0;
+  }
+  for (uint i = 0; i < n; i++) {
+    jpipe_in[jpipe_in_len++] = jtag_rev8(jpipe_tdo[1 + i]);
+  }
+  jpipe_stat.from_fpga += n;
+  jpipe_flush();
+
+  if ((hdr & JPIPE_READY) && jpipe_out_len) {
+    jpipe_stat.to_fpga += jpipe_out_len;
+    jpipe_out_len = 0;
+    return true;
+  }
+  return n != 0;
+}
+
+static void jpipe_task(__unused void *params)
+{
+  pio_jtag_inst_t *jtag;
+  uint32_t clkdiv;
+  uint n;
+
+  while(1) {
+    if (jpipe_ir_len && tud_cdc_n_connected(CDC_PIPE)) {
+      jtag = gmm7550_jtag_acquire_background();
+      if (!jtag) {
+        /* parked while another JTAG client is active */
+        vTaskDelay(1);
+        continue;
+      }
+      clkdiv = jtag_get_clkdiv(jtag);
+      jtag_set_clk_freq(jtag, JPIPE_TCK_KHZ);
+      jpipe_select(jtag);
+      for (n = 0; n < JPIPE_BURST && jpipe_frame(jtag); n++) {}
+      jtag_set_clkdiv(jtag, clkdiv);
+      gmm7550_jtag_release_background();
+      /* poll once per tick while the pipe is idle */
+      if (n < JPIPE_BURST) vTaskDelay(1);
+    } else {
+      jpipe_out_len = jpipe_in_len = 0;
+      vTaskDelay(1);
+    }
+  }
+}
+
+#define PIPE_SHORT_HELP "pipe [off | ir [irlen]]\n"
+
+static BaseType_t cli_pipe(char *pcWriteBuffer,
+                           size_t xWriteBufferLen,
+                           const char *pcCmd)
+{
+  const jtag_chain_t *chain;
+  pio_jtag_inst_t *jtag;
+  char *p;
+  BaseType_t p_len;
+  uint32_t ir, ir_len = 0;
+
+  p = (char *)FreeRTOS_CLIGetParameter(pcCmd, 1, &p_len);
+  if (p && p_len == 3 && !strncmp(p, "off", 3)) {
+    jpipe_ir_len = 0;
+  } else if (p) {
+    ir = strtoul(p, NULL, 16);
+    p = (char *)FreeRTOS_CLIGetParameter(pcCmd, 2, &p_len);
+    if (p) {
+      ir_len = strtoul(p, NULL, 10);
+    } else {
+      jtag = gmm7550_jtag_acquire();
+      chain = jtag_chain_get(jtag);
+      gmm7550_jtag_release();
+      if (chain->n_devices == 1) ir_len = chain->ir_len[0];
+    }
+    if (ir_len == 0 || ir_len > 32) {
+      strncpy(pcWriteBuffer, "Error: IR length should be 1..32\n", xWriteBufferLen);
+      return pdFALSE;
+    }
+    jpipe_ir = ir;
+    jpipe_ir_len = ir_len;
+  }
+
+  if (jpipe_ir_len) {
+    snprintf(pcWriteBuffer, xWriteBufferLen,
+             "JTAG pipe: IR 0x%lx/%d, %lu frames, %lu bytes to FPGA, %lu from FPGA, %lu dropped\n",
+             (unsigned long)jpipe_ir, jpipe_ir_len,
+             (unsigned long)jpipe_stat.frames, (unsigned long)jpipe_stat.to_fpga,
+             (unsigned long)jpipe_stat.from_fpga, (unsigned long)jpipe_stat.dropped);
+  } else {
+    strncpy(pcWriteBuffer, "JTAG pipe is off\n", xWriteBufferLen);
+  }
+  return pdFALSE;
+}
+
+static const CLI_Command_Definition_t pipe_cmd = {
+  "pipe",
+  PIPE_SHORT_HELP
+  "  JTAG pipe to FPGA user logic: status, turn off, or\n"
+  "  set USER instruction (hex) and IR length (default -- from the chain scan)\n\n",
+  cli_pipe,
+  -1
+};
+
+void cli_register_jpipe(void)
+{
+  FreeRTOS_CLIRegisterCommand(&pipe_cmd);
+}
+
+void gmm7550_jpipe_init(void)
+{
+  xTaskCreate(jpipe_task, "JPIPE",
+              configMINIMAL_STACK_SIZE,
+              NULL,
+              (tskIDLE_PRIORITY + 2UL),
+              NULL
+              );
+}
@@ -18,10 +18,17 @@
  * Copyright (c) 2024 DESKTOP-M9CCUTI\ian
  */
 
+#include <string.h>
+
 #include "pico/stdlib.h"
 #include "tusb.h"
+#include "device/usbd_pvt.h"
+#include "semphr.h"
 #include "pio_jtag.h"
+#include "chain.h"
+#include "trace.h"
 #include "gmm7550_control.h"
+#include "FreeRTOS_CLI.h"
 
 #include "cmd.h"
 
@@ -30,6 +37,49 @@ pio_jtag_inst_t jtag = {
   .sm = 0
 };
 
+/* JTAG engine is shared by DirtyJTAG, SVF player and the other JTAG
+ * channels.  DirtyJTAG takes it per command packet, or keeps it while
+ * a CMD_XFER_LONG shift spans several packets: the PIO waits for the
+ * rest of the data meanwhile.  A shift without data for
+ * DJTAG_STREAM_TIMEOUT_MS is abandoned, the host has gone.
+ *
+ * JTAG pipe is a background user: it changes IR, TAP state and TCK
+ * behind the back of the other clients, so it gets the engine only if
+ * nobody else has used it for JTAG_BACKGROUND_HOLDOFF_MS. */
+static SemaphoreHandle_t jtag_mutex;
+/* last release by a foreground user */
+static volatile TickType_t jtag_t_release;
+
+#define DJTAG_STREAM_TIMEOUT_MS 2000
+#define JTAG_BACKGROUND_HOLDOFF_MS 1000
+
+pio_jtag_inst_t *gmm7550_jtag_acquire(void)
+{
+  xSemaphoreTake(jtag_mutex, portMAX_DELAY);
+  return &jtag;
+}
+
+void gmm7550_jtag_release(void)
+{
+  jtag_t_release = xTaskGetTickCount();
+  xSemaphoreGive(jtag_mutex);
+}
+
+pio_jtag_inst_t *gmm7550_jtag_acquire_background(void)
+{
+  xSemaphoreTake(jtag_mutex, portMAX_DELAY);
+  if (xTaskGetTickCount() - jtag_t_release < pdMS_TO_TICKS(JTAG_BACKGROUND_HOLDOFF_MS)) {
+    xSemaphoreGive(jtag_mutex);
+    return NULL;
+  }
+  return &jtag;
+}
+
+void gmm7550_jtag_release_background(void)
+{
+  xSemaphoreGive(jtag_mutex);
+}
+
 static void djtag_init(void)
 {
   gpio_set_function_masked((1<<GMM7550_JTAG_TDI_PIN) |
@@ -46,70 +96,508 @@ static void djtag_init(void)
 }
 
 typedef uint8_t cmd_buffer[64];
-static cmd_buffer tx_buf;
 
-static uint wr_buffer_number = 0;
-static uint rd_buffer_number = 0;
+/*
+ * DirtyJTAG vendor interface is served by an application class driver
+ * (see usbd_app_driver_get_cb() in usb.c): OUT transfers go directly
+ * into the command buffers, TDO data is written by cmd_handle() into
+ * the TX buffer which is then sent as is, no FIFO copies in between.
+ *
+ * Command buffers form a single producer/single consumer ring: USB
+ * device task (djtag_itf_xfer_cb()) fills buffers and advances
+ * wr_buffer_number, JTAG task executes them and advances
+ * rd_buffer_number, the busy flag passes a buffer from one to the
+ * other.  USB task has higher priority, so OUT transfers keep going
+ * while JTAG task waits for the PIO.
+ */
+static uint8_t probe_rhport;
+static volatile uint8_t probe_ep_out = 0;
+static volatile uint8_t probe_ep_in = 0;
+static volatile bool probe_reset = false;
+
+static TaskHandle_t jtag_task_handle;
+
+static volatile uint wr_buffer_number = 0;
+static volatile uint rd_buffer_number = 0;
+
+/* JTAG engine is kept by an open CMD_XFER_LONG stream, JTAG task */
+static bool stream_owned = false;
+static TickType_t stream_t_last;
 
 typedef struct buffer_info
 {
   volatile uint8_t count;
   volatile uint8_t busy;
-  cmd_buffer buffer;
+  CFG_TUSB_MEM_ALIGN cmd_buffer buffer;
 } buffer_info;
 
-#define N_BUFFERS (4)
-buffer_info buffer_infos[N_BUFFERS];
+/* Queue depth is set by the USB buffer profile, the buffers come from
+ * its pool (profile.c) */
+static buffer_info *buffer_infos;
+static uint n_buffers;
+const uint djtag_buffer_size = sizeof(buffer_info);
+
+/* Replies to several queued command packets are collected and go out
+ * in full packets; the last short packet is sent once the command
+ * queue drains and the host waits for it.  Two buffers: cmd_handle()
+ * writes into one while the other is being sent.  A buffer holds the
+ * worst case reply to one packet plus some room for coalescing.
+ * TX state is owned by JTAG task.
+ */
+#define TX_BUF_SIZE (CMD_MAX_REPLY * sizeof(cmd_buffer) + 1024)
+CFG_TUSB_MEM_SECTION CFG_TUSB_MEM_ALIGN static uint8_t tx_bufs[2][TX_BUF_SIZE];
+static uint tx_fill = 0;     /* buffer for the next replies */
+static uint32_t tx_len = 0;  /* reply bytes in tx_bufs[tx_fill] */
+
+/* Start OUT transfer into the next free command buffer (either task) */
+static void jtag_rx_arm(void)
+{
+  uint8_t ep = probe_ep_out;
+
+  while (ep && usbd_edpt_claim(probe_rhport, ep)) {
+    if (!buffer_infos[wr_buffer_number].busy) {
+      usbd_edpt_xfer(probe_rhport, ep,
+                     buffer_infos[wr_buffer_number].buffer, sizeof(cmd_buffer));
+      return;
+    }
+    usbd_edpt_release(probe_rhport, ep);
+    /* the other task could free the buffer while we held the claim */
+    if (buffer_infos[wr_buffer_number].busy) return;
+  }
+}
+
+#if GMM7550_USB_BENCH
+/*
+ * USB link benchmark (DJTAG_BENCH_* modes, GMM7550_VREQ_BENCH request
+ * or 'bench' CLI command).  Echo goes through the command queue and
+ * reply buffers as DirtyJTAG commands do, with cmd_handle() replaced
+ * by a copy; sink drops OUT packets and source keeps the IN endpoint
+ * busy with tx_bufs[0] (a byte counter pattern) in USB device task.
+ * The host should not have DirtyJTAG replies pending when the mode
+ * is changed, and should drain the IN endpoint after the source mode.
+ */
+static volatile uint8_t bench_mode = DJTAG_BENCH_OFF;
+static struct {
+  uint32_t bytes[2];  /* [OUT, IN] */
+  uint32_t xfers[2];
+  uint32_t t_start;   /* mode set */
+  uint32_t t_first;   /* first and last transfer */
+  uint32_t t_last;
+} bench_stat;
+
+static void bench_count(uint dir, uint32_t n)
+{
+  uint32_t t = time_us_32();
+
+  if (bench_stat.xfers[0] + bench_stat.xfers[1] == 0) bench_stat.t_first = t;
+  bench_stat.t_last = t;
+  bench_stat.bytes[dir] += n;
+  bench_stat.xfers[dir]++;
+}
+
+static void bench_source(void)
+{
+  uint8_t ep = probe_ep_in;
+
+  if (ep && usbd_edpt_claim(probe_rhport, ep)) {
+    usbd_edpt_xfer(probe_rhport, ep, tx_bufs[0], TX_BUF_SIZE);
+  }
+}
+
+static void bench_set_mode(uint mode)
+{
+  memset(&bench_stat, 0, sizeof(bench_stat));
+  bench_stat.t_start = time_us_32();
+  if (mode == DJTAG_BENCH_SOURCE) {
+    for (uint i = 0; i < TX_BUF_SIZE; i++) tx_bufs[0][i] = i;
+  }
+  bench_mode = mode;
+  if (mode == DJTAG_BENCH_SOURCE) bench_source();
+}
+
+/* OUT: wValue -- mode, IN: u32 mode, OUT bytes, OUT transfers, IN
+ * bytes, IN transfers, first and last transfer time (us since mode set) */
+bool djtag_bench_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_request_t const *request)
+{
+  static uint32_t reply[7];
+
+  if (stage != CONTROL_STAGE_SETUP) return true;
+
+  if (request->bmRequestType_bit.direction == TUSB_DIR_OUT) {
+    if (request->wValue > DJTAG_BENCH_SINK) return false;
+    bench_set_mode(request->wValue);
+    return tud_control_status(rhport, request);
+  }
+  reply[0] = bench_mode;
+  reply[1] = bench_stat.bytes[0];
+  reply[2] = bench_stat.xfers[0];
+  reply[3] = bench_stat.bytes[1];
+  reply[4] = bench_stat.xfers[1];
+  reply[5] = bench_stat.xfers[0] + bench_stat.xfers[1] ? bench_stat.t_first - bench_stat.t_start : 0;
+  reply[6] = bench_stat.xfers[0] + bench_stat.xfers[1] ? bench_stat.t_last - bench_stat.t_start : 0;
+  return tud_control_xfer(rhport, request, reply, sizeof(reply));
+}
+#endif
+
+/* Send full packets, or everything if the host waits for the answer */
+static void jtag_tx_send(bool all)
+{
+  uint32_t len = all ? tx_len : (tx_len & ~(sizeof(cmd_buffer) - 1));
+  uint8_t ep = probe_ep_in;
+
+  if (!ep || !len || !usbd_edpt_claim(probe_rhport, ep))
+    return;
+
+  usbd_edpt_xfer(probe_rhport, ep, tx_bufs[tx_fill], len);
+  trace_tx_queued();
+  tx_fill ^= 1;
+  /* short tail is kept to be coalesced with the next replies */
+  memcpy(tx_bufs[tx_fill], tx_bufs[tx_fill ^ 1] + len, tx_len - len);
+  tx_len -= len;
+}
+
+void djtag_itf_init(void)
+{
+  probe_ep_out = probe_ep_in = 0;
+}
+
+/* Producer side is reset here, JTAG task resets its own state */
+void djtag_itf_reset(uint8_t rhport)
+{
+  (void) rhport;
+  probe_ep_out = probe_ep_in = 0;
+#if GMM7550_USB_BENCH
+  bench_mode = DJTAG_BENCH_OFF;
+#endif
+  for (int i = 0; i < n_buffers; i++) {
+    buffer_infos[i].busy = false;
+  }
+  wr_buffer_number = 0;
+  probe_reset = true;
+  if (jtag_task_handle) xTaskNotifyGive(jtag_task_handle);
+}
+
+uint16_t djtag_itf_open(uint8_t rhport, tusb_desc_interface_t const *itf_desc, uint16_t max_len)
+{
+  uint16_t len = sizeof(tusb_desc_interface_t) + 2 * sizeof(tusb_desc_endpoint_t);
+  uint8_t ep_out, ep_in;
+
+  /* MPSSE interface (subclass 0xFF) belongs to the vendor class */
+  if (itf_desc->bInterfaceClass != TUSB_CLASS_VENDOR_SPECIFIC ||
+      itf_desc->bInterfaceSubClass != 0 ||
+      itf_desc->bNumEndpoints != 2 || probe_ep_out || max_len < len)
+    return 0;
 
+  if (!usbd_open_edpt_pair(rhport, tu_desc_next(itf_desc), 2, TUSB_XFER_BULK,
+                           &ep_out, &ep_in))
+    return 0;
+
+  probe_rhport = rhport;
+  probe_ep_in = ep_in;
+  probe_ep_out = ep_out;
+  jtag_rx_arm();
+  return len;
+}
+
+bool djtag_itf_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_request_t const *request)
+{
+  return false;
+}
+
+bool djtag_itf_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes)
+{
+  if (ep_addr == probe_ep_out) {
+#if GMM7550_USB_BENCH
+    if (bench_mode != DJTAG_BENCH_OFF) bench_count(0, xferred_bytes);
+    if (bench_mode == DJTAG_BENCH_SOURCE || bench_mode == DJTAG_BENCH_SINK) {
+      jtag_rx_arm();
+      return true;
+    }
+#endif
+    if (result == XFER_RESULT_SUCCESS && xferred_bytes) {
+      uint bnum = wr_buffer_number;
+      buffer_infos[bnum].count = xferred_bytes;
+      buffer_infos[bnum].busy = true;
+      bnum++; //switch buffer
+      wr_buffer_number = (bnum == n_buffers) ? 0 : bnum;
+      if (buffer_infos[wr_buffer_number].busy) usbstat_full(ep_addr);
+    }
+    jtag_rx_arm();
+  } else if (ep_addr == probe_ep_in) {
+#if GMM7550_USB_BENCH
+    if (bench_mode != DJTAG_BENCH_OFF) bench_count(1, xferred_bytes);
+    if (bench_mode == DJTAG_BENCH_SOURCE) {
+      bench_source();
+      return true;
+    }
+#endif
+    trace_tx_done();
+  }
+  /* new commands or TX buffer is free */
+  xTaskNotifyGive(jtag_task_handle);
+  return true;
+}
+
+/* USB device task: TinyUSB events and callbacks, including the producer side */
+static void usbd_task(__unused void *params)
+{
+  while(1) {
+    if (tud_inited()) {
+      tud_task(); // blocks until there is an event
+    } else {
+      vTaskDelay(1);
+    }
+  }
+}
+
+/* Abandon CMD_XFER_LONG stream, if any, and give the engine back */
+static void jtag_stream_reset(void)
+{
+  if (!stream_owned) gmm7550_jtag_acquire();
+  cmd_reset(&jtag);
+  gmm7550_jtag_release();
+  stream_owned = false;
+}
+
+/* Consumer: execute queued command packets */
 static void jtag_task(__unused void *params)
 {
   while(1) {
-    if ((buffer_infos[wr_buffer_number].busy == false)) {
-      //If tud_task() is called and tud_vendor_read isn't called immediately (i.e before calling tud_task again)
-      //after there is data available, there is a risk that data from 2 BULK OUT transaction will be (partially) combined into one
-      //The DJTAG protocol does not tolerate this.
-      tud_task();// tinyusb device task
-      if (tud_vendor_available()) {
-        uint bnum = wr_buffer_number;
-        uint count = tud_vendor_read(buffer_infos[wr_buffer_number].buffer, 64);
-        if (count != 0) {
-          buffer_infos[bnum].count = count;
-          buffer_infos[bnum].busy = true;
-          wr_buffer_number = wr_buffer_number + 1; //switch buffer
-          if (wr_buffer_number == N_BUFFERS) {
-            wr_buffer_number = 0;
-          }
-        }
+    ulTaskNotifyTake(pdTRUE, 1);
+    if (probe_reset) {
+      probe_reset = false;
+      rd_buffer_number = 0;
+      tx_len = 0;
+      jtag_stream_reset();
+    }
+    if (stream_owned &&
+        xTaskGetTickCount() - stream_t_last > pdMS_TO_TICKS(DJTAG_STREAM_TIMEOUT_MS)) {
+      jtag_stream_reset();
+    }
+    while (1) {
+      uint bnum = rd_buffer_number;
+      bool pending = buffer_infos[bnum].busy;
+      bool fits = tx_len + CMD_MAX_REPLY * buffer_infos[bnum].count <= TX_BUF_SIZE;
+      if (!pending || !fits || probe_reset) {
+        if (pending && !fits) usbstat_full(probe_ep_in);
+        jtag_tx_send(!pending || !fits);
+        break;
+      }
+#if GMM7550_USB_BENCH
+      if (bench_mode == DJTAG_BENCH_ECHO) {
+        memcpy(tx_bufs[tx_fill] + tx_len, buffer_infos[bnum].buffer, buffer_infos[bnum].count);
+        tx_len += buffer_infos[bnum].count;
+      } else
+#endif
+      {
+        if (!stream_owned) gmm7550_jtag_acquire();
+        trace_packet(bnum);
+        tx_len += cmd_handle(&jtag, buffer_infos[bnum].buffer, buffer_infos[bnum].count,
+                             tx_bufs[tx_fill] + tx_len);
+        stream_owned = cmd_stream_open();
+        stream_t_last = xTaskGetTickCount();
+        if (!stream_owned) gmm7550_jtag_release();
       }
+      buffer_infos[bnum].busy = false;
+      bnum++; //switch buffer
+      rd_buffer_number = (bnum == n_buffers) ? 0 : bnum;
+      jtag_rx_arm(); // in case the ring was full
+      jtag_tx_send(false);
+    }
+  }
+}
+
+#define JTAG_SHORT_HELP "jtag [s]\n"
+
+static BaseType_t cli_jtag(char *pcWriteBuffer,
+                           size_t xWriteBufferLen,
+                           const char *pcCmd)
+{
+  static const jtag_chain_t *chain = NULL;
+  static int line = 0;
+  char *p;
+  BaseType_t p_len;
+
+  if (!chain) {
+    p = (char *)FreeRTOS_CLIGetParameter(pcCmd, 1, &p_len);
+    if (p && (p_len != 1 || *p != 's')) {
+      strncpy(pcWriteBuffer, "JTAG command argument should be 's'", xWriteBufferLen);
+      return pdFALSE;
+    }
+    gmm7550_jtag_acquire();
+    chain = p ? jtag_chain_scan(&jtag) : jtag_chain_get(&jtag);
+    gmm7550_jtag_release();
+    line = 0;
+  }
+
+  if (line == 0) {
+    if (chain->n_devices) {
+      snprintf(pcWriteBuffer, xWriteBufferLen,
+               "%d device(s), IR length %d (TDO side first)\n",
+               chain->n_devices, chain->ir_total);
+    } else {
+      strncpy(pcWriteBuffer, "No JTAG devices found\n", xWriteBufferLen);
+    }
+  } else if (line <= chain->n_devices) {
+    int d = line - 1;
+    if (chain->idcode[d]) {
+      snprintf(pcWriteBuffer, xWriteBufferLen,
+               "  %d: IDCODE 0x%08lx", d, (unsigned long)chain->idcode[d]);
+    } else {
+      snprintf(pcWriteBuffer, xWriteBufferLen, "  %d: no IDCODE", d);
     }
-    if (buffer_infos[rd_buffer_number].busy) {
-      cmd_handle(&jtag, buffer_infos[rd_buffer_number].buffer, buffer_infos[rd_buffer_number].count, tx_buf);
-      buffer_infos[rd_buffer_number].busy = false;
-      rd_buffer_number++; //switch buffer
-      if (rd_buffer_number == N_BUFFERS) {
-        rd_buffer_number = 0;
+    if (chain->ir_len[d]) {
+      snprintf(pcWriteBuffer + strlen(pcWriteBuffer), xWriteBufferLen - strlen(pcWriteBuffer),
+               ", IR %d\n", chain->ir_len[d]);
+    } else {
+      strncat(pcWriteBuffer, "\n", xWriteBufferLen - strlen(pcWriteBuffer) - 1);
+    }
+  }
+
+  if (line++ < chain->n_devices) return pdTRUE;
+  chain = NULL;
+  return pdFALSE;
+}
+
+static const CLI_Command_Definition_t jtag_cmd = {
+  "jtag",
+  JTAG_SHORT_HELP
+  "  Print JTAG scan chain (cached), 's' -- rescan\n\n",
+  cli_jtag,
+  -1
+};
+
+#if GMM7550_DJTAG_TRACE
+static BaseType_t cli_trace(char *pcWriteBuffer,
+                            size_t xWriteBufferLen,
+                            const char *pcCmd)
+{
+  static uint32_t line = 0;
+  static uint32_t count;
+  const djtag_trace_t *t;
+  char *p;
+  BaseType_t p_len;
+
+  if (line == 0) {
+    p = (char *)FreeRTOS_CLIGetParameter(pcCmd, 1, &p_len);
+    if (p) {
+      if (p_len == 1 && *p == 'c') {
+        trace_clear();
+        *pcWriteBuffer = '\0';
+      } else {
+        strncpy(pcWriteBuffer, "Trace command argument should be 'c'\n", xWriteBufferLen);
       }
+      return pdFALSE;
     }
-    vTaskDelay(1);
+    count = trace_count();
+    snprintf(pcWriteBuffer, xWriteBufferLen,
+             "# DirtyJTAG trace, %lu entries\n# op bits buf start done flushed\n",
+             (unsigned long)count);
+  } else {
+    t = trace_get(line - 1);
+    snprintf(pcWriteBuffer, xWriteBufferLen, "%02x %lu %u %lu %lu %lu\n",
+             t->opcode, (unsigned long)t->bits, t->buffer,
+             (unsigned long)t->t_start, (unsigned long)t->t_done, (unsigned long)t->t_flushed);
   }
+
+  if (line++ < count) return pdTRUE;
+  line = 0;
+  return pdFALSE;
 }
 
-//this is to work around the fact that tinyUSB does not handle setup request automatically
-//Hence this boiler plate code
-bool tud_vendor_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_request_t const * request)
+static const CLI_Command_Definition_t trace_cmd = {
+  "trace",
+  "trace [c]\n"
+  "  Dump DirtyJTAG command trace (times in us), 'c' -- clear\n\n",
+  cli_trace,
+  -1
+};
+#endif
+
+#if GMM7550_USB_BENCH
+static const char * const bench_modes[] = { "off", "echo", "source", "sink" };
+
+static BaseType_t cli_bench(char *pcWriteBuffer,
+                            size_t xWriteBufferLen,
+                            const char *pcCmd)
 {
-  if (stage != CONTROL_STAGE_SETUP) return true;
-  return false;
+  uint32_t dt;
+  char *p;
+  BaseType_t p_len;
+  uint m;
+
+  p = (char *)FreeRTOS_CLIGetParameter(pcCmd, 1, &p_len);
+  if (p) {
+    for (m = 0; m < sizeof(bench_modes) / sizeof(bench_modes[0]); m++) {
+      if (p_len == strlen(bench_modes[m]) && !strncmp(p, bench_modes[m], p_len)) break;
+    }
+    if (m == sizeof(bench_modes) / sizeof(bench_modes[0])) {
+      strncpy(pcWriteBuffer, "Bench mode should be off, echo, source or sink\n", xWriteBufferLen);
+      return pdFALSE;
+    }
+    bench_set_mode(m);
+  }
+
+  dt = bench_stat.t_last - bench_stat.t_first;
+  snprintf(pcWriteBuffer, xWriteBufferLen,
+           "USB bench %s: OUT %lu bytes/%lu xfers, IN %lu bytes/%lu xfers in %lu us",
+           bench_modes[bench_mode],
+           (unsigned long)bench_stat.bytes[0], (unsigned long)bench_stat.xfers[0],
+           (unsigned long)bench_stat.bytes[1], (unsigned long)bench_stat.xfers[1],
+           (unsigned long)dt);
+  if (dt) {
+    snprintf(pcWriteBuffer + strlen(pcWriteBuffer), xWriteBufferLen - strlen(pcWriteBuffer),
+             ", %lu/%lu kB/s",
+             (unsigned long)((uint64_t)bench_stat.bytes[0] * 1000 / dt),
+             (unsigned long)((uint64_t)bench_stat.bytes[1] * 1000 / dt));
+  }
+  strncat(pcWriteBuffer, "\n", xWriteBufferLen - strlen(pcWriteBuffer) - 1);
+  return pdFALSE;
+}
+
+static const CLI_Command_Definition_t bench_cmd = {
+  "bench",
+  "bench [off | echo | source | sink]\n"
+  "  USB link benchmark mode of DirtyJTAG interface, counters since mode set\n\n",
+  cli_bench,
+  -1
+};
+#endif
+
+void cli_register_jtag(void)
+{
+  FreeRTOS_CLIRegisterCommand(&jtag_cmd);
+#if GMM7550_DJTAG_TRACE
+  FreeRTOS_CLIRegisterCommand(&trace_cmd);
+#endif
+#if GMM7550_USB_BENCH
+  FreeRTOS_CLIRegisterCommand(&bench_cmd);
+#endif
 }
 
 void gmm7550_jtag_init(void)
 {
+  jtag_mutex = xSemaphoreCreateMutex();
   djtag_init();
 
+  n_buffers = usb_profile->djtag_depth;
+  buffer_infos = usb_profile_alloc(n_buffers * sizeof(buffer_info));
+  if (!buffer_infos) {
+    n_buffers = 2; /* the pool is exhausted, bare minimum */
+    buffer_infos = pvPortMalloc(n_buffers * sizeof(buffer_info));
+  }
+  memset(buffer_infos, 0, n_buffers * sizeof(buffer_info));
+
   xTaskCreate(jtag_task, "JTAG",
               configMINIMAL_STACK_SIZE,
               NULL,
               (tskIDLE_PRIORITY + 3UL),
+              &jtag_task_handle
+              );
+  xTaskCreate(usbd_task, "USBD",
+              configMINIMAL_STACK_SIZE,
+              NULL,
+              (tskIDLE_PRIORITY + 4UL),
               NULL
               );
 }
@@ -8,6 +8,7 @@
  */
 
 #include "pico/stdlib.h"
+#include "hardware/vreg.h"
 #include "gmm7550_control.h"
 
 #define BLINK_ON_TIME 100
@@ -41,15 +42,40 @@ void blink_task(__unused void *params)
   }
 }
 
+static void sys_clock_init(void)
+{
+#ifdef GMM7550_SYS_CLK_KHZ
+  vreg_set_voltage(VREG_VOLTAGE_1_15);
+  busy_wait_us_32(1000); /* let the core voltage settle */
+  set_sys_clock_khz(GMM7550_SYS_CLK_KHZ, true);
+#endif
+}
+
 int main(void)
 {
+  sys_clock_init();
+
   cli_connected = false;
   cli_was_connected = false;
   spi_connected = false;
 
+  usb_profile_init();
   serial_init(NULL);
+  gmm7550_i2c_init();
   gmm7550_spi_init();
   gmm7550_jtag_init();
+  gmm7550_svf_init();
+  gmm7550_xvc_init();
+  gmm7550_jpipe_init();
+#if GMM7550_MPSSE
+  gmm7550_mpsse_init();
+#endif
+#if GMM7550_MSC
+  gmm7550_msc_init();
+#endif
+#if GMM7550_DFU
+  gmm7550_dfu_init();
+#endif
 
   xTaskCreate(blink_task, "Blink",
               configMINIMAL_STACK_SIZE, /* stack size */
@@ -0,0 +1,389 @@
+/*
+ * Raspberry Pi RP2040 Control firmware for GMM-7550 module
+ * https://www.gmm7550.dev/doc/rp2040.html
+ *
+ * Copyright (c) 2026 Anton Kuzmin <ak@gmm7550.dev>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* FTDI MPSSE emulation (JTAG subset) on top of the PIO JTAG engine.
+ *
+ * The vendor interface looks like channel B of FT2232H (interface 1,
+ * endpoints 0x04/0x83), so that libftdi based tools with hard-coded
+ * endpoints work as well (openFPGALoader --ftdi-channel B, openocd
+ * "ftdi channel 1").  Both need the VID/PID of the probe.
+ *
+ * Supported: clock data bytes/bits in/out (MSB or LSB first, clock
+ * edge bits are ignored -- TDI changes on the falling and TDO is
+ * sampled on the rising edge of TCK), TMS sequences, clock only
+ * commands, TCK/TDI/TMS/TDO on the low byte GPIO and clock divisor.
+ */
+
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "tusb.h"
+#include "pio_jtag.h"
+#include "tap.h"
+#include "gmm7550_control.h"
+
+#define MPSSE_ITF 0 /* TinyUSB vendor class instance */
+
+/* Data shifting command bits */
+#define MPSSE_WRITE_NEG  0x01
+#define MPSSE_BITMODE    0x02
+#define MPSSE_READ_NEG   0x04
+#define MPSSE_LSB        0x08
+#define MPSSE_DO_WRITE   0x10
+#define MPSSE_DO_READ    0x20
+#define MPSSE_WRITE_TMS  0x40
+
+/* Other commands */
+#define MPSSE_SET_BITS_LOW   0x80
+#define MPSSE_GET_BITS_LOW   0x81
+#define MPSSE_SET_BITS_HIGH  0x82
+#define MPSSE_GET_BITS_HIGH  0x83
+#define MPSSE_LOOPBACK_ON    0x84
+#define MPSSE_LOOPBACK_OFF   0x85
+#define MPSSE_SET_CLK_DIV    0x86
+#define MPSSE_SEND_IMMEDIATE 0x87
+#define MPSSE_DIV5_OFF       0x8A
+#define MPSSE_DIV5_ON        0x8B
+#define MPSSE_3PHASE_ON      0x8C
+#define MPSSE_3PHASE_OFF     0x8D
+#define MPSSE_CLK_BITS       0x8E
+#define MPSSE_CLK_BYTES      0x8F
+#define MPSSE_ADAPTIVE_ON    0x96
+#define MPSSE_ADAPTIVE_OFF   0x97
+#define MPSSE_BAD_COMMAND    0xFA
+
+/* Low byte GPIO in MPSSE JTAG mode */
+#define MPSSE_TCK (1 << 0)
+#define MPSSE_TDI (1 << 1)
+#define MPSSE_TDO (1 << 2)
+#define MPSSE_TMS (1 << 3)
+
+/* FTDI vendor requests */
+#define SIO_RESET             0x00
+#define SIO_POLL_MODEM_STATUS 0x05
+#define SIO_SET_LATENCY_TIMER 0x09
+#define SIO_GET_LATENCY_TIMER 0x0A
+#define SIO_READ_PINS         0x0C
+#define SIO_READ_EEPROM       0x90
+
+#define SIO_RESET_PURGE_RX    1
+
+#define MPSSE_CHUNK 512 /* bytes shifted per PIO transfer */
+
+static uint8_t tdi_buf[MPSSE_CHUNK] __aligned(4);
+static uint8_t tdo_buf[MPSSE_CHUNK + 4] __aligned(4);
+
+/* Every IN packet starts with two modem status bytes */
+static const uint8_t modem_status[2] = {0x32, 0x60};
+static uint8_t tx_pkt[64];
+static uint tx_pkt_len = 2;
+static bool tx_short = false; /* short packet is waiting in TX FIFO */
+
+static volatile bool tms_level = false; /* read by mpsse_control_xfer_cb() */
+static volatile bool tdi_level = false;
+static bool div5 = true; /* 12 MHz base clock after reset, 60 MHz without divide by 5 */
+static uint8_t latency = 16;
+
+/* Write assembled packet into TX FIFO.  A short packet ends the host
+ * transfer, it should leave the FIFO before the next packet is added,
+ * otherwise the packet boundaries (and status bytes) would shift.
+ */
+static void mpsse_send(void)
+{
+  while (tud_vendor_n_write_available(MPSSE_ITF) < (tx_short ? CFG_TUD_VENDOR_TX_BUFSIZE : tx_pkt_len)) {
+    if (!tud_vendor_n_mounted(MPSSE_ITF)) break;
+    vTaskDelay(1);
+  }
+  tud_vendor_n_write(MPSSE_ITF, tx_pkt, tx_pkt_len);
+  tx_short = (tx_pkt_len < sizeof(tx_pkt));
+  if (tx_short) tud_vendor_n_write_flush(MPSSE_ITF);
+  tx_pkt_len = 2;
+}
+
+static void mpsse_flush(void)
+{
+  if (tx_pkt_len > 2) mpsse_send();
+}
+
+static void mpsse_putc(const uint8_t c)
+{
+  tx_pkt[tx_pkt_len++] = c;
+  if (tx_pkt_len == sizeof(tx_pkt)) mpsse_send();
+}
+
+/* Commands come as a byte stream, the answer is sent when the host
+ * has nothing more to say (or on SEND_IMMEDIATE)
+ */
+static void mpsse_read(uint8_t *buf, uint32_t len)
+{
+  while (len) {
+    uint32_t n = tud_vendor_n_read(MPSSE_ITF, buf, len);
+    if (n == 0) {
+      mpsse_flush();
+      vTaskDelay(1);
+    }
+    buf += n;
+    len -= n;
+  }
+}
+
+static uint8_t mpsse_getc(void)
+{
+  uint8_t c;
+  mpsse_read(&c, 1);
+  return c;
+}
+
+/* MPSSE shifts leave the TAP state unknown for DirtyJTAG and SVF */
+static pio_jtag_inst_t *mpsse_jtag_acquire(void)
+{
+  pio_jtag_inst_t *jtag = gmm7550_jtag_acquire();
+  tap_invalidate();
+  return jtag;
+}
+
+static void mpsse_shift_bytes(const uint8_t op, uint32_t len)
+{
+  const bool lsb = op & MPSSE_LSB;
+
+  while (len) {
+    uint32_t n = MIN(len, MPSSE_CHUNK);
+    if (op & MPSSE_DO_WRITE) {
+      mpsse_read(tdi_buf, n);
+      if (lsb) {
+        for (uint32_t i = 0; i < n; i++) tdi_buf[i] = jtag_rev8(tdi_buf[i]);
+      }
+      tdi_level = tdi_buf[n - 1] & 1;
+    } else {
+      memset(tdi_buf, tdi_level ? 0xff : 0x00, n);
+    }
+
+    /* TMS is low during the shift, as in Shift-xR state */
+    pio_jtag_inst_t *jtag = mpsse_jtag_acquire();
+    jtag_transfer(jtag, n * 8, tdi_buf, (op & MPSSE_DO_READ) ? tdo_buf : NULL);
+    gmm7550_jtag_release();
+    tms_level = false;
+
+    if (op & MPSSE_DO_READ) {
+      for (uint32_t i = 0; i < n; i++) mpsse_putc(lsb ? jtag_rev8(tdo_buf[i]) : tdo_buf[i]);
+    }
+    len -= n;
+  }
+}
+
+static void mpsse_shift_bits(const uint8_t op, const uint nbits)
+{
+  const bool lsb = op & MPSSE_LSB;
+  uint8_t tdi, tdo;
+  pio_jtag_inst_t *jtag;
+
+  if (op & MPSSE_DO_WRITE) {
+    tdi = mpsse_getc();
+    if (lsb) tdi = jtag_rev8(tdi); /* first bit is the MSB for the PIO */
+    tdi_level = (tdi >> (8 - nbits)) & 1;
+  } else {
+    tdi = tdi_level ? 0xff : 0x00;
+  }
+
+  tdi_buf[0] = tdi;
+  jtag = mpsse_jtag_acquire();
+  jtag_transfer(jtag, nbits, tdi_buf, tdo_buf); /* may store a byte past the shifted ones */
+  gmm7550_jtag_release();
+  tms_level = false;
+  tdo = tdo_buf[0];
+
+  if (op & MPSSE_DO_READ) {
+    /* LSB first: bits come in from the top, MSB first: from the bottom */
+    mpsse_putc(lsb ? (jtag_rev8(tdo) << (8 - nbits)) : (tdo >> (8 - nbits)));
+  }
+}
+
+static void mpsse_shift_tms(const uint8_t op, const uint nbits)
+{
+  uint8_t data = mpsse_getc();
+  uint8_t tdo = 0;
+  pio_jtag_inst_t *jtag;
+
+  tdi_level = data >> 7;
+  jtag = mpsse_jtag_acquire();
+  for (uint i = 0; i < nbits; i++) {
+    tms_level = (data >> i) & 1;
+    tdo >>= 1;
+    tdo |= jtag_strobe(jtag, 1, tms_level, tdi_level) & 0x80;
+  }
+  gmm7550_jtag_release();
+
+  if (op & MPSSE_DO_READ) mpsse_putc(tdo);
+}
+
+static void mpsse_clock(const uint32_t nbits)
+{
+  pio_jtag_inst_t *jtag = mpsse_jtag_acquire();
+  jtag_strobe(jtag, nbits, tms_level, tdi_level);
+  gmm7550_jtag_release();
+}
+
+static void mpsse_set_bits_low(const uint8_t value)
+{
+  pio_jtag_inst_t *jtag = mpsse_jtag_acquire();
+  tdi_level = value & MPSSE_TDI;
+  tms_level = value & MPSSE_TMS;
+  jtag_set_tms(jtag, tms_level);
+  gmm7550_jtag_release();
+}
+
+static uint8_t mpsse_get_bits_low(void)
+{
+  pio_jtag_inst_t *jtag = gmm7550_jtag_acquire();
+  bool tdo = jtag_get_tdo(jtag);
+  gmm7550_jtag_release();
+  return (tdo ? MPSSE_TDO : 0) | (tdi_level ? MPSSE_TDI : 0) | (tms_level ? MPSSE_TMS : 0);
+}
+
+/* SIO_READ_PINS comes in the USB device task, which must not wait for
+ * the JTAG engine: TDI and TMS are the levels last set by MPSSE, TDO is
+ * read from the pin as is */
+static uint8_t mpsse_read_pins(void)
+{
+  bool tdo = gpio_get(GMM7550_JTAG_TDO_PIN);
+  return (tdo ? MPSSE_TDO : 0) | (tdi_level ? MPSSE_TDI : 0) | (tms_level ? MPSSE_TMS : 0);
+}
+
+static void mpsse_set_clk_div(const uint16_t div)
+{
+  uint base_khz = div5 ? 12000 : 60000;
+  uint khz = base_khz / ((1 + div) * 2);
+
+  pio_jtag_inst_t *jtag = gmm7550_jtag_acquire();
+  jtag_set_clk_freq(jtag, khz ? khz : 1);
+  gmm7550_jtag_release();
+}
+
+static void mpsse_command(const uint8_t op)
+{
+  uint32_t len;
+
+  if (!(op & 0x80)) {
+    if (op & MPSSE_WRITE_TMS) {
+      if ((op & MPSSE_DO_WRITE) || !(op & MPSSE_BITMODE)) goto bad_command;
+      mpsse_shift_tms(op, (mpsse_getc() & 7) + 1);
+    } else if (op & MPSSE_BITMODE) {
+      mpsse_shift_bits(op, (mpsse_getc() & 7) + 1);
+    } else {
+      len = mpsse_getc();
+      len |= mpsse_getc() << 8;
+      mpsse_shift_bytes(op, len + 1);
+    }
+    return;
+  }
+
+  switch (op) {
+  case MPSSE_SET_BITS_LOW:
+    mpsse_set_bits_low(mpsse_getc());
+    mpsse_getc(); /* direction, fixed */
+    break;
+  case MPSSE_SET_BITS_HIGH:
+    mpsse_getc();
+    mpsse_getc();
+    break;
+  case MPSSE_GET_BITS_LOW:
+    mpsse_putc(mpsse_get_bits_low());
+    break;
+  case MPSSE_GET_BITS_HIGH:
+    mpsse_putc(0);
+    break;
+  case MPSSE_SET_CLK_DIV:
+    len = mpsse_getc();
+    len |= mpsse_getc() << 8;
+    mpsse_set_clk_div(len);
+    break;
+  case MPSSE_DIV5_OFF:
+  case MPSSE_DIV5_ON:
+    div5 = (op == MPSSE_DIV5_ON);
+    break;
+  case MPSSE_CLK_BITS:
+    mpsse_clock((mpsse_getc() & 7) + 1);
+    break;
+  case MPSSE_CLK_BYTES:
+    len = mpsse_getc();
+    len |= mpsse_getc() << 8;
+    mpsse_clock((len + 1) * 8);
+    break;
+  case MPSSE_SEND_IMMEDIATE:
+    mpsse_flush();
+    break;
+  case MPSSE_LOOPBACK_ON:
+  case MPSSE_LOOPBACK_OFF:
+  case MPSSE_3PHASE_ON:
+  case MPSSE_3PHASE_OFF:
+  case MPSSE_ADAPTIVE_ON:
+  case MPSSE_ADAPTIVE_OFF:
+    break;
+  default:
+    goto bad_command;
+  }
+  return;
+
+ bad_command:
+  mpsse_putc(MPSSE_BAD_COMMAND);
+  mpsse_putc(op);
+}
+
+static void mpsse_task(__unused void *params)
+{
+  memcpy(tx_pkt, modem_status, sizeof(modem_status));
+  while (1) {
+    mpsse_command(mpsse_getc());
+  }
+}
+
+/* FTDI vendor requests.  Serial port settings and bit mode are
+ * accepted and ignored: the interface is always in MPSSE mode.
+ */
+bool mpsse_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_request_t const *request)
+{
+  static uint8_t reply[2];
+
+  if (stage != CONTROL_STAGE_SETUP) return true;
+
+  switch (request->bRequest) {
+  case SIO_RESET:
+    if (request->wValue == SIO_RESET_PURGE_RX) tud_vendor_n_read_flush(MPSSE_ITF);
+    return tud_control_status(rhport, request);
+  case SIO_POLL_MODEM_STATUS:
+    memcpy(reply, modem_status, sizeof(modem_status));
+    return tud_control_xfer(rhport, request, reply, 2);
+  case SIO_SET_LATENCY_TIMER:
+    latency = request->wValue & 0xff;
+    return tud_control_status(rhport, request);
+  case SIO_GET_LATENCY_TIMER:
+    reply[0] = latency;
+    return tud_control_xfer(rhport, request, reply, 1);
+  case SIO_READ_PINS:
+    reply[0] = mpsse_read_pins();
+    return tud_control_xfer(rhport, request, reply, 1);
+  case SIO_READ_EEPROM:
+    reply[0] = reply[1] = 0xff; /* blank EEPROM */
+    return tud_control_xfer(rhport, request, reply, 2);
+  default:
+    if (request->bmRequestType_bit.direction == TUSB_DIR_OUT)
+      return tud_control_status(rhport, request);
+    return false;
+  }
+}
+
+void gmm7550_mpsse_init(void)
+{
+  xTaskCreate(mpsse_task, "MPSSE",
+              configMINIMAL_STACK_SIZE,
+              NULL,
+              (tskIDLE_PRIORITY + 2UL),
+              NULL
+              );
+}
@@ -0,0 +1,702 @@
+/*
+ * Raspberry Pi RP2040 Control firmware for GMM-7550 module
+ * https://www.gmm7550.dev/doc/rp2040.html
+ *
+ * Copyright (c) 2026 Anton Kuzmin <ak@gmm7550.dev>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* USB mass storage: drag-and-drop FPGA configuration and NOR programming.
+ *
+ * Two logical units, each one is a small virtual FAT12 volume:
+ *   LUN 0 "GMM CONFIG" -- a file copied to it is streamed into the FPGA
+ *                         (SPI Passive mode, cfg 4 and mux 1 are set)
+ *   LUN 1 "GMM FLASH"  -- a file copied to it is programmed into the
+ *                         configuration NOR of the module from address 0
+ *                         (mux 2, FPGA is held in soft reset meanwhile)
+ * Boot sector is generated, FAT and root directory are kept in RAM, so
+ * the host sees its own metadata.  The data area is not stored: file
+ * data go to the target as the blocks arrive, and read back as zeros.
+ * STATUS.TXT and 'msc' CLI command report the last operation.
+ *
+ * Hosts write file data and directory entries in any order, so a stream
+ * starts with the first data block which is not zeros, a directory or
+ * a known metadata file, and goes on with consecutive blocks; a block
+ * out of sequence ends the stream and starts a new one.  The stream is
+ * complete when the directory entry of the file gives its size and all
+ * the data are there, or after MSC_IDLE_TIMEOUT_MS without data.  Then
+ * the volume is reset to the empty state and the host is told that the
+ * medium has changed.  One file per copy: 'sync' or eject on the host
+ * side makes it go out promptly.
+ *
+ * FPGA configuration runs in USB device task: a block is held back (the
+ * tail of the last one is beyond the file size), the previous block is
+ * written by DMA while the next one is being received.  NOR programming
+ * runs in MSC task: 4 KiB sectors are assembled in a ring of buffers,
+ * every one is erased and programmed while the next ones are received;
+ * the host is NAKed when the ring is full.
+ */
+
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "gmm7550_control.h"
+#include "tusb.h"
+#include "semphr.h"
+#include "queue.h"
+#include "FreeRTOS_CLI.h"
+
+#define MSC_LUN_CONFIG 0
+#define MSC_LUN_FLASH  1
+#define MSC_N_LUNS     2
+
+#define MSC_BLOCK_SIZE  512
+#define MSC_BLOCK_COUNT (4 * 1024 * 1024 / MSC_BLOCK_SIZE)
+
+#define MSC_IDLE_TIMEOUT_MS 10000 /* no more data, size is not known */
+#define MSC_RESET_DELAY_MS  1000  /* volume reset, after the last write */
+
+/* FAT12 volume layout */
+#define FAT_SECTORS_PER_CLUSTER 8 /* 4 KiB, NOR erase sector */
+#define FAT_RESERVED_SECTORS    1
+#define FAT_SECTORS             4
+#define FAT_ROOT_ENTRIES        32
+#define FAT_ROOT_SECTORS        (FAT_ROOT_ENTRIES * 32 / MSC_BLOCK_SIZE)
+#define FAT_FIRST_FAT           FAT_RESERVED_SECTORS
+#define FAT_FIRST_ROOT          (FAT_FIRST_FAT + FAT_SECTORS)
+#define FAT_FIRST_DATA          (FAT_FIRST_ROOT + FAT_ROOT_SECTORS)
+#define FAT_CLUSTER(lba)        (2 + ((lba) - FAT_FIRST_DATA) / FAT_SECTORS_PER_CLUSTER)
+#define FAT_STATUS_CLUSTER      2
+#define FAT_STATUS_LBA          FAT_FIRST_DATA
+#define FAT_STATUS_SIZE         128
+
+#define FAT_ATTR_RO     0x01
+#define FAT_ATTR_VOLUME 0x08
+#define FAT_ATTR_DIR    0x10
+
+#if CFG_TUD_MSC_EP_BUFSIZE != MSC_BLOCK_SIZE
+#error "MSC callbacks are expected to get one block at a time"
+#endif
+
+/* Configuration NOR of the module (IS25LP032) */
+#define NOR_SIZE        (4 * 1024 * 1024)
+#define NOR_SECTOR_SIZE 4096
+#define NOR_PAGE_SIZE   256
+#define NOR_CMD_PP      0x02
+#define NOR_CMD_RDSR    0x05
+#define NOR_CMD_WREN    0x06
+#define NOR_CMD_SE      0x20
+#define NOR_SR_WIP      0x01
+
+#define MSC_NOR_BUFFERS 3
+
+typedef enum {
+  MSC_IDLE,
+  MSC_STREAM,
+  MSC_CLOSING, /* NOR programming is finishing */
+  MSC_DONE,
+  MSC_ERROR
+} msc_state_t;
+
+static const char * const msc_state_names[] = {
+  "idle", "busy", "busy", "done", "error"
+};
+
+typedef struct {
+  const char *label;     /* 11 characters */
+  const char *name;
+  uint8_t fat[FAT_SECTORS * MSC_BLOCK_SIZE];
+  uint8_t root[FAT_ROOT_SECTORS * MSC_BLOCK_SIZE];
+  bool changed;          /* report medium change to the host */
+  bool reset_pending;    /* volume reset after the stream */
+  uint32_t t_write;      /* ms, last write of any block */
+  /* current or the last stream */
+  msc_state_t state;
+  const char *error;
+  uint32_t first_lba;
+  uint32_t next_lba;
+  uint32_t size;         /* from the directory entry, 0 -- not known */
+  uint32_t received;
+  uint32_t bytes;        /* sent to FPGA or programmed */
+  uint32_t t_start;      /* ms */
+  uint32_t t_last;
+  /* directory entry seen before the data */
+  uint16_t dir_cluster;
+  uint32_t dir_size;
+} msc_lun_t;
+
+static msc_lun_t msc_luns[MSC_N_LUNS] = {
+  { .label = "GMM CONFIG ", .name = "CONFIG" },
+  { .label = "GMM FLASH  ", .name = "FLASH"  },
+};
+
+/* Stream state is shared by USB device task and MSC task */
+static SemaphoreHandle_t msc_mutex;
+
+/* FPGA configuration: the block held back and the one under DMA */
+static uint8_t cfg_buf[2][MSC_BLOCK_SIZE];
+static uint cfg_idx;
+static bool cfg_held;
+
+/* NOR programming */
+typedef struct {
+  uint32_t addr;
+  uint8_t blocks;        /* bitmap of valid 512-byte blocks */
+  uint8_t data[NOR_SECTOR_SIZE];
+} nor_buffer_t;
+
+static nor_buffer_t nor_buffers[MSC_NOR_BUFFERS];
+static QueueHandle_t nor_free_q;
+static QueueHandle_t nor_full_q;
+static nor_buffer_t *nor_fill;   /* being assembled, USB device task */
+static uint8_t nor_erased[NOR_SIZE / NOR_SECTOR_SIZE / 8];
+
+static inline uint32_t msc_now(void)
+{
+  return xTaskGetTickCount() * portTICK_PERIOD_MS;
+}
+
+static inline void put16(uint8_t *p, uint16_t v)
+{
+  p[0] = v; p[1] = v >> 8;
+}
+
+static inline void put32(uint8_t *p, uint32_t v)
+{
+  put16(p, v); put16(p + 2, v >> 16);
+}
+
+static inline uint16_t get16(const uint8_t *p)
+{
+  return p[0] | (p[1] << 8);
+}
+
+static inline uint32_t get32(const uint8_t *p)
+{
+  return get16(p) | ((uint32_t)get16(p + 2) << 16);
+}
+
+static void msc_volume_reset(msc_lun_t *l)
+{
+  uint8_t *e;
+
+  memset(l->fat, 0, sizeof(l->fat));
+  /* media descriptor, end of chain, STATUS.TXT cluster */
+  l->fat[0] = 0xf8; l->fat[1] = 0xff; l->fat[2] = 0xff;
+  l->fat[3] = 0xff; l->fat[4] = 0x0f;
+
+  memset(l->root, 0, sizeof(l->root));
+  e = l->root;
+  memcpy(e, l->label, 11);
+  e[11] = FAT_ATTR_VOLUME;
+  e += 32;
+  memcpy(e, "STATUS  TXT", 11);
+  e[11] = FAT_ATTR_RO;
+  put16(e + 26, FAT_STATUS_CLUSTER);
+  put32(e + 28, FAT_STATUS_SIZE);
+}
+
+static void msc_boot_sector(uint lun, uint8_t *b)
+{
+  memset(b, 0, MSC_BLOCK_SIZE);
+  b[0] = 0xeb; b[1] = 0x3c; b[2] = 0x90;
+  memcpy(b + 3, "MSWIN4.1", 8);
+  put16(b + 11, MSC_BLOCK_SIZE);
+  b[13] = FAT_SECTORS_PER_CLUSTER;
+  put16(b + 14, FAT_RESERVED_SECTORS);
+  b[16] = 1;                             /* number of FATs */
+  put16(b + 17, FAT_ROOT_ENTRIES);
+  put16(b + 19, MSC_BLOCK_COUNT);
+  b[21] = 0xf8;                          /* fixed media */
+  put16(b + 22, FAT_SECTORS);
+  put16(b + 24, 1);                      /* sectors per track */
+  put16(b + 26, 1);                      /* heads */
+  b[36] = 0x80;                          /* drive number */
+  b[38] = 0x29;                          /* extended boot signature */
+  put32(b + 39, 0x75500000 + lun);       /* volume ID */
+  memcpy(b + 43, msc_luns[lun].label, 11);
+  memcpy(b + 54, "FAT12   ", 8);
+  b[510] = 0x55; b[511] = 0xaa;
+}
+
+static void msc_status(uint lun, char *s, size_t n)
+{
+  const msc_lun_t *l = &msc_luns[lun];
+
+  snprintf(s, n, "%s: %s, %lu bytes in %lu ms%s%s\n",
+           l->name, msc_state_names[l->state],
+           (unsigned long)l->bytes, (unsigned long)(l->t_last - l->t_start),
+           l->error ? ", " : "", l->error ? l->error : "");
+}
+
+static void msc_status_file(uint lun, uint8_t *b)
+{
+  char s[FAT_STATUS_SIZE];
+
+  memset(b, 0, MSC_BLOCK_SIZE);
+  memset(b, ' ', FAT_STATUS_SIZE);
+  msc_status(lun, s, sizeof(s));
+  memcpy(b, s, strlen(s));
+  b[FAT_STATUS_SIZE - 1] = '\n';
+}
+
+/* Blocks which never start a stream */
+static bool msc_block_ignored(const uint8_t *b)
+{
+  /* a new subdirectory */
+  if (!memcmp(b, ".          ", 11) && (b[11] & FAT_ATTR_DIR)) return true;
+  /* AppleDouble file (macOS) */
+  if (b[0] == 0x00 && b[1] == 0x05 && b[2] == 0x16 && b[3] == 0x07) return true;
+  /* IndexerVolumeGuid (Windows), UTF-16 "{" */
+  if (b[0] == '{' && b[1] == 0x00) return true;
+  for (uint i = 0; i < MSC_BLOCK_SIZE; i++) {
+    if (b[i]) return false;
+  }
+  return true;
+}
+
+/*
+ * NOR flash, MSC task
+ */
+static void nor_cmd(const uint8_t *cmd, uint len)
+{
+  gmm7550_spi_set_cs(true);
+  gmm7550_spi_transfer(cmd, NULL, len);
+  gmm7550_spi_set_cs(false);
+}
+
+static void nor_wait(bool sleep)
+{
+  uint8_t tx[2] = { NOR_CMD_RDSR, 0 };
+  uint8_t rx[2];
+
+  do {
+    if (sleep) vTaskDelay(1);
+    gmm7550_spi_set_cs(true);
+    gmm7550_spi_transfer(tx, rx, 2);
+    gmm7550_spi_set_cs(false);
+  } while (rx[1] & NOR_SR_WIP);
+}
+
+static void nor_addr_cmd(uint8_t op, uint32_t addr, const uint8_t *data, uint len)
+{
+  static const uint8_t wren = NOR_CMD_WREN;
+  uint8_t cmd[4] = { op, addr >> 16, addr >> 8, addr };
+
+  nor_cmd(&wren, 1);
+  gmm7550_spi_set_cs(true);
+  gmm7550_spi_transfer(cmd, NULL, sizeof(cmd));
+  if (len) gmm7550_spi_transfer(data, NULL, len);
+  gmm7550_spi_set_cs(false);
+}
+
+static bool nor_page_blank(const uint8_t *p)
+{
+  for (uint i = 0; i < NOR_PAGE_SIZE; i++) {
+    if (p[i] != 0xff) return false;
+  }
+  return true;
+}
+
+static void nor_program(nor_buffer_t *b)
+{
+  msc_lun_t *l = &msc_luns[MSC_LUN_FLASH];
+  const uint sector = b->addr / NOR_SECTOR_SIZE;
+  const uint8_t *p;
+
+  /* a sector is erased once per stream, blocks may come in parts */
+  if (!(nor_erased[sector / 8] & (1 << (sector % 8)))) {
+    nor_addr_cmd(NOR_CMD_SE, b->addr, NULL, 0);
+    nor_wait(true);
+    nor_erased[sector / 8] |= 1 << (sector % 8);
+  }
+  for (uint blk = 0; blk < NOR_SECTOR_SIZE / MSC_BLOCK_SIZE; blk++) {
+    if (!(b->blocks & (1 << blk))) continue;
+    for (uint off = blk * MSC_BLOCK_SIZE; off < (blk + 1) * MSC_BLOCK_SIZE; off += NOR_PAGE_SIZE) {
+      p = b->data + off;
+      if (!nor_page_blank(p)) {
+        nor_addr_cmd(NOR_CMD_PP, b->addr + off, p, NOR_PAGE_SIZE);
+        nor_wait(false);
+      }
+      l->bytes += NOR_PAGE_SIZE;
+    }
+  }
+}
+
+static void nor_submit(void)
+{
+  uint8_t idx = nor_fill - nor_buffers;
+
+  xQueueSend(nor_full_q, &idx, 0);
+  nor_fill = NULL;
+}
+
+/* Returns 0 if there is no free buffer */
+static int32_t flash_block(msc_lun_t *l, uint32_t lba, const uint8_t *buf)
+{
+  const uint32_t off = (lba - l->first_lba) * MSC_BLOCK_SIZE;
+  const uint32_t addr = off & ~(NOR_SECTOR_SIZE - 1);
+  uint8_t idx;
+
+  if (off >= NOR_SIZE) {
+    l->error = "file is larger than NOR";
+    return MSC_BLOCK_SIZE;
+  }
+  if (nor_fill && nor_fill->addr != addr) nor_submit();
+  if (!nor_fill) {
+    if (xQueueReceive(nor_free_q, &idx, 0) != pdTRUE) return 0;
+    nor_fill = &nor_buffers[idx];
+    nor_fill->addr = addr;
+    nor_fill->blocks = 0;
+  }
+  memcpy(nor_fill->data + (off - addr), buf, MSC_BLOCK_SIZE);
+  nor_fill->blocks |= 1 << ((off - addr) / MSC_BLOCK_SIZE);
+  if (nor_fill->blocks == (1 << (NOR_SECTOR_SIZE / MSC_BLOCK_SIZE)) - 1) nor_submit();
+  return MSC_BLOCK_SIZE;
+}
+
+/*
+ * FPGA configuration, USB device task
+ */
+static int32_t config_block(msc_lun_t *l, const uint8_t *buf)
+{
+  if (cfg_held) {
+    gmm7550_spi_write_dma(cfg_buf[cfg_idx], MSC_BLOCK_SIZE);
+    l->bytes += MSC_BLOCK_SIZE;
+    cfg_idx ^= 1; /* its DMA is over, waited for by the write above */
+  }
+  memcpy(cfg_buf[cfg_idx], buf, MSC_BLOCK_SIZE);
+  cfg_held = true;
+  return MSC_BLOCK_SIZE;
+}
+
+static void config_finish(msc_lun_t *l)
+{
+  uint32_t len = MSC_BLOCK_SIZE;
+
+  if (cfg_held) {
+    if (l->size) {
+      len = l->size > l->bytes ? MIN(l->size - l->bytes, MSC_BLOCK_SIZE) : 0;
+    }
+    if (len) gmm7550_spi_write_dma(cfg_buf[cfg_idx], len);
+    l->bytes += len;
+    cfg_held = false;
+  }
+  gmm7550_spi_wait();
+  gmm7550_spi_set_cs(false);
+  gmm7550_spi_release();
+}
+
+/*
+ * Streams, with msc_mutex taken
+ */
+static bool msc_stream_start(uint lun, uint32_t lba)
+{
+  msc_lun_t *l = &msc_luns[lun];
+
+  l->first_lba = l->next_lba = lba;
+  l->received = l->bytes = 0;
+  l->size = (FAT_CLUSTER(lba) == l->dir_cluster) ? l->dir_size : 0;
+  l->t_start = l->t_last = msc_now();
+  l->error = NULL;
+  l->reset_pending = false;
+
+  if (!gmm7550_is_ready()) {
+    l->error = "module is off or in reset";
+  } else if (!gmm7550_spi_acquire()) {
+    l->error = "SPI is in use";
+  } else if (lun == MSC_LUN_CONFIG) {
+    /* SPI Passive configuration mode, FPGA SPI */
+    gmm7550_i2c_acquire();
+    if (!gmm7550_set_cfg(4) || !gmm7550_set_mux(1)) {
+      gmm7550_spi_release();
+      l->error = "can not set SPI Mux / Configuration Mode";
+    } else {
+      gmm7550_sreset(2);
+      cfg_held = false;
+      gmm7550_spi_set_cs(true);
+    }
+    gmm7550_i2c_release();
+  } else {
+    gmm7550_i2c_acquire();
+    if (!gmm7550_set_mux(2)) {
+      gmm7550_spi_release();
+      l->error = "can not set SPI Mux";
+    } else {
+      gmm7550_sreset(1);
+      memset(nor_erased, 0, sizeof(nor_erased));
+      nor_fill = NULL;
+    }
+    gmm7550_i2c_release();
+  }
+  l->state = l->error ? MSC_ERROR : MSC_STREAM;
+  return !l->error;
+}
+
+static void msc_stream_end(uint lun, const char *error, bool reset)
+{
+  msc_lun_t *l = &msc_luns[lun];
+
+  if (error) l->error = error;
+  l->reset_pending = reset;
+  if (lun == MSC_LUN_CONFIG) {
+    config_finish(l);
+    l->state = l->error ? MSC_ERROR : MSC_DONE;
+  } else {
+    /* MSC task finishes it once all the buffers are programmed */
+    if (nor_fill) nor_submit();
+    l->state = MSC_CLOSING;
+  }
+}
+
+static void msc_check_size(uint lun)
+{
+  msc_lun_t *l = &msc_luns[lun];
+
+  if (l->state == MSC_STREAM && l->size && l->received >= l->size) {
+    msc_stream_end(lun, NULL, true);
+  }
+}
+
+/* Look for the directory entry of the stream */
+static void msc_dir_update(uint lun)
+{
+  msc_lun_t *l = &msc_luns[lun];
+  const uint8_t *e;
+  uint16_t cluster;
+  uint32_t size;
+
+  for (uint i = 0; i < FAT_ROOT_ENTRIES; i++) {
+    e = l->root + 32 * i;
+    if (e[0] == 0x00) break;
+    if (e[0] == 0xe5 || (e[11] & (FAT_ATTR_VOLUME | FAT_ATTR_DIR))) continue;
+    cluster = get16(e + 26);
+    size = get32(e + 28);
+    if (cluster <= FAT_STATUS_CLUSTER || size == 0) continue;
+    if (l->state == MSC_STREAM) {
+      if (cluster == FAT_CLUSTER(l->first_lba)) l->size = size;
+    } else {
+      l->dir_cluster = cluster;
+      l->dir_size = size;
+    }
+  }
+  msc_check_size(lun);
+}
+
+/* Returns 0 if the block should be retried later */
+static int32_t msc_data_write(uint lun, uint32_t lba, const uint8_t *buf)
+{
+  msc_lun_t *l = &msc_luns[lun];
+  int32_t ret;
+
+  if (FAT_CLUSTER(lba) == FAT_STATUS_CLUSTER) return MSC_BLOCK_SIZE;
+  if (l->state == MSC_CLOSING) return 0;
+  if (l->state == MSC_STREAM && lba != l->next_lba) {
+    msc_stream_end(lun, "out of sequence write", false);
+    if (l->state == MSC_CLOSING) return 0;
+  }
+  if (l->state != MSC_STREAM) {
+    if (msc_block_ignored(buf)) return MSC_BLOCK_SIZE;
+    if (!msc_stream_start(lun, lba)) return -1;
+  }
+
+  ret = (lun == MSC_LUN_CONFIG) ? config_block(l, buf) : flash_block(l, lba, buf);
+  if (ret > 0) {
+    l->next_lba = lba + 1;
+    l->received += MSC_BLOCK_SIZE;
+    l->t_last = msc_now();
+    msc_check_size(lun);
+  }
+  return ret;
+}
+
+/* Timeouts and the end of NOR programming, MSC task */
+static void msc_poll(uint lun)
+{
+  msc_lun_t *l = &msc_luns[lun];
+  const uint32_t now = msc_now();
+
+  if (l->state == MSC_STREAM && now - l->t_last > MSC_IDLE_TIMEOUT_MS) {
+    msc_stream_end(lun, NULL, true);
+  }
+  if (l->state == MSC_CLOSING &&
+      uxQueueMessagesWaiting(nor_free_q) == MSC_NOR_BUFFERS) {
+    gmm7550_spi_release();
+    gmm7550_sreset(0);
+    l->t_last = now;
+    l->state = l->error ? MSC_ERROR : MSC_DONE;
+  }
+  if (l->reset_pending && l->state != MSC_CLOSING &&
+      now - l->t_write > MSC_RESET_DELAY_MS) {
+    msc_volume_reset(l);
+    l->reset_pending = false;
+    l->dir_cluster = 0;
+    l->changed = true;
+  }
+}
+
+static void msc_task(__unused void *params)
+{
+  uint8_t idx;
+
+  while (1) {
+    if (xQueueReceive(nor_full_q, &idx, pdMS_TO_TICKS(100)) == pdTRUE) {
+      nor_program(&nor_buffers[idx]);
+      xQueueSend(nor_free_q, &idx, 0);
+    }
+    xSemaphoreTake(msc_mutex, portMAX_DELAY);
+    for (uint lun = 0; lun < MSC_N_LUNS; lun++) {
+      msc_poll(lun);
+    }
+    xSemaphoreGive(msc_mutex);
+  }
+}
+
+/*
+ * TinyUSB MSC callbacks
+ */
+uint8_t tud_msc_get_maxlun_cb(void)
+{
+  return MSC_N_LUNS;
+}
+
+void tud_msc_inquiry_cb(uint8_t lun, uint8_t vendor_id[8], uint8_t product_id[16], uint8_t product_rev[4])
+{
+  const char *name = msc_luns[lun].name;
+
+  memcpy(vendor_id, "GMM7550 ", 8);
+  memset(product_id, ' ', 16);
+  memcpy(product_id, name, strlen(name));
+  memcpy(product_rev, "1.0 ", 4);
+}
+
+bool tud_msc_test_unit_ready_cb(uint8_t lun)
+{
+  if (msc_luns[lun].changed) {
+    msc_luns[lun].changed = false;
+    /* medium may have changed */
+    tud_msc_set_sense(lun, SCSI_SENSE_UNIT_ATTENTION, 0x28, 0x00);
+    return false;
+  }
+  return true;
+}
+
+void tud_msc_capacity_cb(uint8_t lun, uint32_t *block_count, uint16_t *block_size)
+{
+  (void) lun;
+  *block_count = MSC_BLOCK_COUNT;
+  *block_size = MSC_BLOCK_SIZE;
+}
+
+bool tud_msc_start_stop_cb(uint8_t lun, uint8_t power_condition, bool start, bool load_eject)
+{
+  (void) lun; (void) power_condition; (void) start; (void) load_eject;
+  return true;
+}
+
+int32_t tud_msc_read10_cb(uint8_t lun, uint32_t lba, uint32_t offset, void *buffer, uint32_t bufsize)
+{
+  msc_lun_t *l = &msc_luns[lun];
+  uint8_t *b = buffer;
+
+  if (offset || bufsize != MSC_BLOCK_SIZE || lba >= MSC_BLOCK_COUNT) return -1;
+
+  if (lba < FAT_FIRST_FAT) {
+    msc_boot_sector(lun, b);
+  } else if (lba < FAT_FIRST_ROOT) {
+    memcpy(b, l->fat + (lba - FAT_FIRST_FAT) * MSC_BLOCK_SIZE, MSC_BLOCK_SIZE);
+  } else if (lba < FAT_FIRST_DATA) {
+    memcpy(b, l->root + (lba - FAT_FIRST_ROOT) * MSC_BLOCK_SIZE, MSC_BLOCK_SIZE);
+  } else if (lba == FAT_STATUS_LBA) {
+    msc_status_file(lun, b);
+  } else {
+    memset(b, 0, MSC_BLOCK_SIZE);
+  }
+  return bufsize;
+}
+
+int32_t tud_msc_write10_cb(uint8_t lun, uint32_t lba, uint32_t offset, uint8_t *buffer, uint32_t bufsize)
+{
+  msc_lun_t *l = &msc_luns[lun];
+  int32_t ret = bufsize;
+
+  if (offset || bufsize != MSC_BLOCK_SIZE || lba >= MSC_BLOCK_COUNT) return -1;
+
+  xSemaphoreTake(msc_mutex, portMAX_DELAY);
+  l->t_write = msc_now();
+  if (lba < FAT_FIRST_FAT) {
+    /* boot sector is fixed */
+  } else if (lba < FAT_FIRST_ROOT) {
+    memcpy(l->fat + (lba - FAT_FIRST_FAT) * MSC_BLOCK_SIZE, buffer, MSC_BLOCK_SIZE);
+  } else if (lba < FAT_FIRST_DATA) {
+    memcpy(l->root + (lba - FAT_FIRST_ROOT) * MSC_BLOCK_SIZE, buffer, MSC_BLOCK_SIZE);
+    msc_dir_update(lun);
+  } else {
+    ret = msc_data_write(lun, lba, buffer);
+  }
+  xSemaphoreGive(msc_mutex);
+
+  /* TinyUSB calls again with the same block, let MSC task run first */
+  if (ret == 0) vTaskDelay(1);
+  return ret;
+}
+
+int32_t tud_msc_scsi_cb(uint8_t lun, uint8_t const scsi_cmd[16], void *buffer, uint16_t bufsize)
+{
+  (void) buffer; (void) bufsize;
+
+  switch (scsi_cmd[0]) {
+  case SCSI_CMD_PREVENT_ALLOW_MEDIUM_REMOVAL:
+  case 0x35: /* SYNCHRONIZE CACHE (10), nothing is cached */
+    return 0;
+  default:
+    tud_msc_set_sense(lun, SCSI_SENSE_ILLEGAL_REQUEST, 0x20, 0x00);
+    return -1;
+  }
+}
+
+static BaseType_t cli_msc(char *pcWriteBuffer,
+                          size_t xWriteBufferLen,
+                          const char *pcCmd)
+{
+  static uint lun = 0;
+
+  msc_status(lun, pcWriteBuffer, xWriteBufferLen);
+  if (++lun < MSC_N_LUNS) return pdTRUE;
+  lun = 0;
+  return pdFALSE;
+}
+
+static const CLI_Command_Definition_t msc_cmd = {
+  "msc",
+  "msc\n"
+  "  Status of drag-and-drop FPGA configuration and NOR programming\n\n",
+  cli_msc,
+  0
+};
+
+void cli_register_msc(void)
+{
+  FreeRTOS_CLIRegisterCommand(&msc_cmd);
+}
+
+void gmm7550_msc_init(void)
+{
+  msc_mutex = xSemaphoreCreateMutex();
+  nor_free_q = xQueueCreate(MSC_NOR_BUFFERS, sizeof(uint8_t));
+  nor_full_q = xQueueCreate(MSC_NOR_BUFFERS, sizeof(uint8_t));
+  for (uint8_t i = 0; i < MSC_NOR_BUFFERS; i++) {
+    xQueueSend(nor_free_q, &i, 0);
+  }
+  for (uint lun = 0; lun < MSC_N_LUNS; lun++) {
+    msc_volume_reset(&msc_luns[lun]);
+  }
+
+  xTaskCreate(msc_task, "MSC",
+              configMINIMAL_STACK_SIZE,
+              NULL,
+              (tskIDLE_PRIORITY + 2UL),
+              NULL
+              );
+}
@@ -16,7 +16,9 @@ static inline void pll_write_reg(const uint16_t reg, const uint16_t data)
   buf[1] = reg & 0xff;
   buf[2] = data >> 8;
   buf[3] = data & 0xff;
+  gmm7550_i2c_acquire();
   (void) i2c_write_blocking(i2c, CDCE6214_ADDR, buf, 4, false);
+  gmm7550_i2c_release();
 }
 
 static inline uint16_t pll_read_reg(const uint16_t reg)
@@ -27,9 +29,11 @@ static inline uint16_t pll_read_reg(const uint16_t reg)
   tx[0] = reg >> 8;
   tx[1] = reg & 0xff;
 
+  gmm7550_i2c_acquire();
   if (i2c_write_blocking(i2c, CDCE6214_ADDR, tx, 2, true) == 2) {
     (void) i2c_read_blocking(i2c, CDCE6214_ADDR, rx, 2, false);
   }
+  gmm7550_i2c_release();
   return (rx[0] << 8) | rx[1];
 }
 
@@ -73,6 +77,7 @@ static uint16_t page0_b[EEPROM_PAGE_SIZE] = {
 
 static void pll_select_boot_page(const int page)
 {
+  gmm7550_i2c_acquire();
   gmm7550_sreset(1);
   uint8_t io = pca_read_reg(2);
   if (page == 0) {
@@ -82,6 +87,7 @@ static void pll_select_boot_page(const int page)
   }
   pca_write_reg(2, io);
   gmm7550_sreset(0);
+  gmm7550_i2c_release();
 }
 
 static void pll_program_page(const uint16_t *eeprom_data)
@@ -0,0 +1,203 @@
+/*
+ * Raspberry Pi RP2040 Control firmware for GMM-7550 module
+ * https://www.gmm7550.dev/doc/rp2040.html
+ *
+ * Copyright (c) 2026 Anton Kuzmin <ak@gmm7550.dev>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* USB buffer profiles.
+ *
+ * TinyUSB FIFOs of the CDC channels are small and all of the same size,
+ * fixed at build time.  Deep buffers are given to the channels which
+ * need them from one memory pool, the split is defined by a profile:
+ * CDC receive and transmit rings (cdcbuf.c) and the DirtyJTAG command
+ * queue (jtag.c).  The pool is carved out once, before USB is started;
+ * selecting another profile reboots the controller (the choice is kept
+ * in a watchdog scratch register, the default one is set at build time,
+ * GMM7550_USB_PROFILE).
+ */
+
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "hardware/watchdog.h"
+#include "gmm7550_control.h"
+#include "tusb.h"
+#include "timers.h"
+#include "FreeRTOS_CLI.h"
+
+#ifndef GMM7550_USB_PROFILE
+#define GMM7550_USB_PROFILE "default"
+#endif
+
+#define PROFILE_POOL_SIZE    (24 * 1024)
+#define PROFILE_SCRATCH      0           /* watchdog scratch register */
+#define PROFILE_MAGIC        0x50524f00  /* "PRO" and profile index */
+#define PROFILE_REBOOT_MS    100         /* status stage or CLI output goes first */
+
+#define PROFILE_ALIGN(n) (((n) + 3) & ~3)
+
+/* Ring sizes, CDC_SERIAL, CDC_CLI, CDC_SPI, CDC_JTAG, CDC_XVC, CDC_PIPE */
+static const usb_profile_t profiles[] = {
+  { "default", "TinyUSB FIFOs only",
+    GMM7550_DJTAG_QUEUE_DEPTH,
+    { 0, 0, 0, 0, 0, 0 },
+    { 0, 0, 0, 0, 0, 0 } },
+  { "jtag",    "DirtyJTAG queue, JTAG, XVC and pipe channels",
+    64,
+    { 0, 0, 0, 8192, 4096, 2048 },
+    { 0, 0, 0, 1024, 2048, 2048 } },
+  { "spi",     "SPI channel (NOR flash programming)",
+    GMM7550_DJTAG_QUEUE_DEPTH,
+    { 0, 0, 8192, 0, 0, 0 },
+    { 0, 0, 8192, 0, 0, 0 } },
+  { "console", "serial and CLI channels",
+    GMM7550_DJTAG_QUEUE_DEPTH,
+    { 4096,  512, 0, 0, 0, 0 },
+    { 8192, 4096, 0, 0, 0, 0 } },
+};
+#define N_PROFILES (sizeof(profiles) / sizeof(profiles[0]))
+
+const usb_profile_t *usb_profile = &profiles[0];
+
+CFG_TUSB_MEM_SECTION CFG_TUSB_MEM_ALIGN static uint8_t profile_pool[PROFILE_POOL_SIZE];
+static uint32_t profile_pool_used;
+
+static TimerHandle_t profile_timer;
+
+/* Memory for the buffers of the active profile, never freed */
+void *usb_profile_alloc(size_t size)
+{
+  void *p;
+
+  size = PROFILE_ALIGN(size);
+  if (profile_pool_used + size > PROFILE_POOL_SIZE) return NULL;
+  p = profile_pool + profile_pool_used;
+  profile_pool_used += size;
+  return p;
+}
+
+static uint profile_pool_size(const usb_profile_t *p)
+{
+  uint size = PROFILE_ALIGN(p->djtag_depth * djtag_buffer_size);
+
+  for (uint i = 0; i < CFG_TUD_CDC; i++) {
+    size += PROFILE_ALIGN(p->cdc_rx[i]) + PROFILE_ALIGN(p->cdc_tx[i]);
+  }
+  return size;
+}
+
+static int profile_find(const char *name, size_t len)
+{
+  for (uint i = 0; i < N_PROFILES; i++) {
+    if (strlen(profiles[i].name) == len && !strncmp(profiles[i].name, name, len)) return i;
+  }
+  return -1;
+}
+
+/* Before the tasks are started */
+void usb_profile_init(void)
+{
+  const uint32_t s = watchdog_hw->scratch[PROFILE_SCRATCH];
+  int idx = -1;
+
+  if ((s & 0xffffff00) == PROFILE_MAGIC && (s & 0xff) < N_PROFILES) {
+    idx = s & 0xff;
+  }
+  if (idx < 0) idx = profile_find(GMM7550_USB_PROFILE, strlen(GMM7550_USB_PROFILE));
+  if (idx < 0 || profile_pool_size(&profiles[idx]) > PROFILE_POOL_SIZE) idx = 0;
+  usb_profile = &profiles[idx];
+
+  cdcbuf_init();
+}
+
+static void profile_reboot(__unused TimerHandle_t t)
+{
+  tud_disconnect();
+  watchdog_reboot(0, 0, 10);
+}
+
+/* Keep the choice and reboot shortly */
+static bool usb_profile_select(uint idx)
+{
+  if (idx >= N_PROFILES || profile_pool_size(&profiles[idx]) > PROFILE_POOL_SIZE) return false;
+  watchdog_hw->scratch[PROFILE_SCRATCH] = PROFILE_MAGIC | idx;
+  if (!profile_timer) {
+    profile_timer = xTimerCreate("profile", pdMS_TO_TICKS(PROFILE_REBOOT_MS),
+                                 pdFALSE, NULL, profile_reboot);
+  }
+  return profile_timer && xTimerStart(profile_timer, 0) == pdPASS;
+}
+
+/* GMM7550_VREQ_PROFILE, IN request:
+ *   wValue = 0     -- query
+ *   wValue = n + 1 -- switch to profile n, reboot
+ * reply: u8 status (GMM7550_VREQ_OK/EINVAL), u8 active profile,
+ *        u8 number of profiles, u8 0 */
+bool profile_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_request_t const *request)
+{
+  static uint8_t reply[4];
+
+  if (stage != CONTROL_STAGE_SETUP) return true;
+  if (request->bmRequestType_bit.direction != TUSB_DIR_IN) return false;
+
+  reply[0] = GMM7550_VREQ_OK;
+  if (request->wValue && !usb_profile_select(request->wValue - 1)) {
+    reply[0] = GMM7550_VREQ_EINVAL;
+  }
+  reply[1] = usb_profile - profiles;
+  reply[2] = N_PROFILES;
+  reply[3] = 0;
+  return tud_control_xfer(rhport, request, reply, sizeof(reply));
+}
+
+#define PROFILE_SHORT_HELP "profile [name]\n"
+
+static BaseType_t cli_profile(char *pcWriteBuffer,
+                              size_t xWriteBufferLen,
+                              const char *pcCmd)
+{
+  static uint line = 0;
+  const usb_profile_t *p;
+  const char *name;
+  BaseType_t name_len;
+  int idx;
+
+  if (line == 0) {
+    name = FreeRTOS_CLIGetParameter(pcCmd, 1, &name_len);
+    if (name) {
+      idx = profile_find(name, name_len);
+      if (idx < 0) {
+        strncpy(pcWriteBuffer, "Unknown profile\n" PROFILE_SHORT_HELP, xWriteBufferLen);
+      } else if (!usb_profile_select(idx)) {
+        strncpy(pcWriteBuffer, "Profile does not fit into the buffer pool\n", xWriteBufferLen);
+      } else {
+        snprintf(pcWriteBuffer, xWriteBufferLen, "Switching to '%s' profile, rebooting\n",
+                 profiles[idx].name);
+      }
+      return pdFALSE;
+    }
+  }
+
+  p = &profiles[line];
+  snprintf(pcWriteBuffer, xWriteBufferLen, "%c %-8s %5u bytes: %s\n",
+           p == usb_profile ? '*' : ' ', p->name, profile_pool_size(p), p->descr);
+  if (++line < N_PROFILES) return pdTRUE;
+  line = 0;
+  return pdFALSE;
+}
+
+static const CLI_Command_Definition_t profile_cmd = {
+  "profile",
+  PROFILE_SHORT_HELP
+  "  USB buffer profiles (* -- active), switch to another one (reboot)\n\n",
+  cli_profile,
+  -1
+};
+
+void cli_register_profile(void)
+{
+  FreeRTOS_CLIRegisterCommand(&profile_cmd);
+}
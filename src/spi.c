@@ -1,10 +1,17 @@
 #include "pico/stdlib.h"
 #include "hardware/spi.h"
+#include "hardware/dma.h"
 #include "tusb.h"
 #include "gmm7550_control.h"
 
 static spi_inst_t *spi = SPI_INSTANCE(GMM7550_SPI);
 
+/* SPI is shared by the CDC bridge and the mass storage engine (msc.c),
+ * both flags and NCS are changed in a critical section */
+static volatile bool spi_owned = false;
+static volatile bool spi_bridge_busy = false; /* CDC bridge transfer */
+static int spi_tx_dma = -1;
+
 #define SPI_DEFAULT_BIT_RATE (50*1000*1000)
 
 #define SPI_BUFFER_SIZE 64
@@ -16,8 +23,18 @@ static void spi_task()
   uint32_t len;
 
   while(1) {
-    if ((spi_connected = tud_cdc_n_connected(CDC_SPI))) {
+    taskENTER_CRITICAL();
+    if (spi_owned) {
+      spi_connected = false;
+    } else if ((spi_connected = tud_cdc_n_connected(CDC_SPI))) {
       gpio_put(GMM7550_SPI_NCS_PIN, 0);
+      spi_bridge_busy = true;
+    } else {
+      gpio_put(GMM7550_SPI_NCS_PIN, 1);
+    }
+    taskEXIT_CRITICAL();
+
+    if (spi_bridge_busy) {
       if(tud_cdc_n_available(CDC_SPI)) {
         len = tud_cdc_n_read(CDC_SPI, spi_tx_buf, SPI_BUFFER_SIZE);
         if (len) {
@@ -26,8 +43,7 @@ static void spi_task()
           tud_cdc_n_write_flush(CDC_SPI);
         }
       }
-    } else {
-      gpio_put(GMM7550_SPI_NCS_PIN, 1);
+      spi_bridge_busy = false;
     }
     vTaskDelay(1);
   }
@@ -45,6 +61,8 @@ void gmm7550_spi_init(void)
   gpio_set_dir(GMM7550_SPI_NCS_PIN, GPIO_OUT);
   gpio_put(GMM7550_SPI_NCS_PIN, 1);
 
+  spi_tx_dma = dma_claim_unused_channel(true);
+
   xTaskCreate(spi_task, "SPI",
               configMINIMAL_STACK_SIZE,
               NULL,
@@ -66,3 +84,64 @@ void gmm7550_spi_set_cs(const bool cs)
     gpio_put(GMM7550_SPI_NCS_PIN, 1);
   }
 }
+
+/* RTS of the CDC bridge, ignored while the SPI is taken */
+void gmm7550_spi_bridge_cs(const bool cs)
+{
+  taskENTER_CRITICAL();
+  if (!spi_owned) gmm7550_spi_set_cs(cs);
+  taskEXIT_CRITICAL();
+}
+
+/* Exclusive use of the SPI, fails while the CDC bridge is open */
+bool gmm7550_spi_acquire(void)
+{
+  bool ok;
+
+  taskENTER_CRITICAL();
+  ok = !spi_owned && !spi_bridge_busy && !tud_cdc_n_connected(CDC_SPI);
+  if (ok) spi_owned = true;
+  taskEXIT_CRITICAL();
+  return ok;
+}
+
+void gmm7550_spi_release(void)
+{
+  gmm7550_spi_wait();
+  gpio_put(GMM7550_SPI_NCS_PIN, 1);
+  spi_owned = false;
+}
+
+/* Wait for the DMA write to finish and drop the received data */
+void gmm7550_spi_wait(void)
+{
+  dma_channel_wait_for_finish_blocking(spi_tx_dma);
+  while (spi_is_busy(spi)) {}
+  while (spi_is_readable(spi)) {
+    (void) spi_get_hw(spi)->dr;
+  }
+  spi_get_hw(spi)->icr = SPI_SSPICR_RORIC_BITS;
+}
+
+/* Start DMA write of len bytes, the previous one is waited for first.
+ * buf should not be changed until the next gmm7550_spi_*() call. */
+void gmm7550_spi_write_dma(const uint8_t *buf, const uint len)
+{
+  dma_channel_config c = dma_channel_get_default_config(spi_tx_dma);
+
+  gmm7550_spi_wait();
+  channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+  channel_config_set_dreq(&c, spi_get_dreq(spi, true));
+  dma_channel_configure(spi_tx_dma, &c,
+                        &spi_get_hw(spi)->dr, buf, len, true);
+}
+
+void gmm7550_spi_transfer(const uint8_t *tx, uint8_t *rx, const uint len)
+{
+  gmm7550_spi_wait();
+  if (rx) {
+    spi_write_read_blocking(spi, tx, rx, len);
+  } else {
+    spi_write_blocking(spi, tx, len);
+  }
+}
@@ -0,0 +1,534 @@
+/*
+ * Raspberry Pi RP2040 Control firmware for GMM-7550 module
+ * https://www.gmm7550.dev/doc/rp2040.html
+ *
+ * Copyright (c) 2026 Anton Kuzmin <ak@gmm7550.dev>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* SVF player
+ *
+ * SVF file is streamed by the host over the JTAG CDC channel and
+ * executed locally, without USB round trips per TAP operation.
+ * End of file is marked by EOT (Ctrl-D, 0x04) character, then the
+ * player replies with a single line:
+ *   PASS <number of executed statements>
+ *   FAIL <index of the first statement with TDO mismatch>
+ *   ERROR <index of the first statement which cannot be executed>
+ * Statements are counted from 1.  After a failure the rest of the
+ * file is discarded up to EOT.  The JTAG engine is not shared while a
+ * file is played, so the host which stops sending for longer than
+ * SVF_INPUT_TIMEOUT_MS gets ERROR and the engine is given back.  A
+ * file cut short by a disconnect is an ERROR too, even at a statement
+ * boundary.
+ *
+ * Not supported: PIO and PIOMAP statements, SCK run clock (treated
+ * as a time delay only), TRST (there is no TRST signal on GMM-7550).
+ * TDO of header/trailer patterns is compared only if specified in
+ * the corresponding HIR/HDR/TIR/TDR statement.
+ *
+ * A stream starting with SOH character is a GateMate bitstream, it is
+ * handled by gmm7550_jcfg_load() (jcfg.c).
+ */
+
+#include <stdlib.h>
+#include <strings.h>
+
+#include "pico/stdlib.h"
+#include "gmm7550_control.h"
+#include "tusb.h"
+#include "pio_jtag.h"
+#include "tap.h"
+
+#define SVF_EOT 0x04
+
+#define SVF_MAX_DR_BITS (8 * 4096)
+#define SVF_MAX_IR_BITS 1024
+#define SVF_MAX_HT_BITS 256  /* header and trailer patterns */
+
+#define SVF_TOKEN_SIZE 24
+#define SVF_MAX_TOKENS 10
+
+/* one spare byte for the PIO readback of the byte aligned scans */
+#define SVF_BYTES(bits) (((bits) + 7) / 8 + 1)
+
+typedef struct svf_scan {
+  uint32_t len;
+  const uint32_t max_len;
+  bool check; /* TDO is specified */
+  uint8_t *tdi;
+  uint8_t *tdo;
+  uint8_t *mask;
+} svf_scan_t;
+
+/* word aligned buffers allow 32-bit PIO FIFO/DMA transfers */
+#define SVF_SCAN(name, bits)                               \
+  static uint8_t name##_tdi[SVF_BYTES(bits)] __aligned(4); \
+  static uint8_t name##_tdo[SVF_BYTES(bits)];              \
+  static uint8_t name##_mask[SVF_BYTES(bits)];             \
+  static svf_scan_t name = {                               \
+    .len = 0, .max_len = (bits), .check = false,           \
+    .tdi = name##_tdi,                                     \
+    .tdo = name##_tdo,                                     \
+    .mask = name##_mask                                    \
+  }
+
+SVF_SCAN(sdr, SVF_MAX_DR_BITS);
+SVF_SCAN(sir, SVF_MAX_IR_BITS);
+SVF_SCAN(hdr, SVF_MAX_HT_BITS);
+SVF_SCAN(hir, SVF_MAX_HT_BITS);
+SVF_SCAN(tdr, SVF_MAX_HT_BITS);
+SVF_SCAN(tir, SVF_MAX_HT_BITS);
+
+static uint8_t svf_rd[SVF_BYTES(SVF_MAX_DR_BITS)] __aligned(4);
+
+/* Hex digits of the last (...) token, two per byte, first digit is MS */
+static uint8_t svf_hex[SVF_MAX_DR_BITS / 8];
+static uint32_t svf_hex_n;
+
+static tap_state_t svf_endir;
+static tap_state_t svf_enddr;
+static tap_state_t svf_run_state;
+static tap_state_t svf_run_end_state;
+
+typedef enum {
+  TOK_EOF,
+  TOK_WORD,
+  TOK_HEX,
+  TOK_SEMI,
+  TOK_ERROR
+} svf_token_t;
+
+typedef enum {
+  SVF_OK,
+  SVF_MISMATCH,
+  SVF_ERROR
+} svf_status_t;
+
+static svf_token_t svf_last_token;
+
+/*
+ * Input stream
+ */
+
+static uint8_t svf_in_buf[64];
+static uint svf_in_len;
+static uint svf_in_pos;
+static int svf_unget = -1;
+static bool svf_input_lost; /* the host has gone: disconnect or timeout */
+
+static int svf_getc(void)
+{
+  TickType_t t_start = xTaskGetTickCount();
+  int c;
+
+  if (svf_unget >= 0) {
+    c = svf_unget;
+    svf_unget = -1;
+    return c;
+  }
+  while (svf_in_pos == svf_in_len) {
+    if (svf_input_lost) return -1;
+    if (!tud_cdc_n_connected(CDC_JTAG)) {
+      svf_input_lost = true;
+      return -1;
+    }
+    if (tud_cdc_n_available(CDC_JTAG)) {
+      svf_in_len = tud_cdc_n_read(CDC_JTAG, svf_in_buf, sizeof(svf_in_buf));
+      svf_in_pos = 0;
+    } else if (xTaskGetTickCount() - t_start > pdMS_TO_TICKS(SVF_INPUT_TIMEOUT_MS)) {
+      svf_input_lost = true;
+    } else {
+      vTaskDelay(1);
+    }
+  }
+  return svf_in_buf[svf_in_pos++];
+}
+
+static bool svf_is_space(int c)
+{
+  return (c == ' ' || c == '\t' || c == '\r' || c == '\n');
+}
+
+static bool svf_is_hex(int c)
+{
+  return (('0' <= c) && (c <= '9')) ||
+    (('a' <= c) && (c <= 'f')) ||
+    (('A' <= c) && (c <= 'F'));
+}
+
+static uint8_t svf_hex_value(int c)
+{
+  if (c <= '9') return c - '0';
+  if (c <= 'F') return c - 'A' + 10;
+  return c - 'a' + 10;
+}
+
+static svf_token_t svf_read_hex(void)
+{
+  int c;
+  bool overflow = false;
+
+  svf_hex_n = 0;
+  while ((c = svf_getc()) != ')') {
+    if (c < 0 || c == SVF_EOT) return TOK_EOF;
+    if (svf_is_space(c)) continue;
+    if (!svf_is_hex(c)) return TOK_ERROR;
+    if (svf_hex_n < 2 * sizeof(svf_hex)) {
+      if (svf_hex_n & 1) {
+        svf_hex[svf_hex_n >> 1] |= svf_hex_value(c);
+      } else {
+        svf_hex[svf_hex_n >> 1] = svf_hex_value(c) << 4;
+      }
+      svf_hex_n++;
+    } else {
+      overflow = true;
+    }
+  }
+  return overflow ? TOK_ERROR : TOK_HEX;
+}
+
+static svf_token_t svf_token(char *tok)
+{
+  int c;
+  uint n = 0;
+
+  while (1) {
+    c = svf_getc();
+    if (c < 0 || c == SVF_EOT) return (svf_last_token = TOK_EOF);
+    if (c == '!' || c == '/') { /* comment up to the end of line */
+      while ((c = svf_getc()) != '\n') {
+        if (c < 0 || c == SVF_EOT) return (svf_last_token = TOK_EOF);
+      }
+      continue;
+    }
+    if (!svf_is_space(c)) break;
+  }
+
+  if (c == ';') return (svf_last_token = TOK_SEMI);
+  if (c == '(') return (svf_last_token = svf_read_hex());
+
+  do {
+    if (n < SVF_TOKEN_SIZE - 1) tok[n++] = c;
+    c = svf_getc();
+  } while (c >= 0 && c != SVF_EOT && !svf_is_space(c) && c != ';' && c != '(');
+  svf_unget = c;
+  tok[n] = '\0';
+  return (svf_last_token = TOK_WORD);
+}
+
+/* Skip the rest of the statement after an error */
+static void svf_skip_statement(void)
+{
+  char tok[SVF_TOKEN_SIZE];
+
+  while (svf_last_token != TOK_SEMI && svf_last_token != TOK_EOF) {
+    (void) svf_token(tok);
+  }
+}
+
+static void svf_skip_to_eot(void)
+{
+  int c;
+
+  if (svf_last_token == TOK_EOF) return;
+  while ((c = svf_getc()) >= 0 && c != SVF_EOT) {
+  }
+}
+
+/*
+ * Bit vectors (DirtyJTAG order: byte by byte, MSB first)
+ */
+
+static void svf_hex_to_bits(uint8_t *dst, uint32_t nbits)
+{
+  memset(dst, 0, SVF_BYTES(nbits));
+  /* last hex digit holds the first bits to be shifted */
+  for (uint32_t i = 0; (i < nbits) && ((i >> 2) < svf_hex_n); i++) {
+    uint32_t k = svf_hex_n - 1 - (i >> 2);
+    uint8_t nibble = (k & 1) ? (svf_hex[k >> 1] & 0x0f) : (svf_hex[k >> 1] >> 4);
+    if (nibble & (1 << (i & 3))) dst[i >> 3] |= 0x80 >> (i & 7);
+  }
+}
+
+static void svf_set_ones(uint8_t *dst, uint32_t nbits)
+{
+  memset(dst, 0, SVF_BYTES(nbits));
+  memset(dst, 0xff, nbits >> 3);
+  if (nbits & 7) dst[nbits >> 3] = 0xff << (8 - (nbits & 7));
+}
+
+/*
+ * Statements
+ */
+
+static bool svf_stable_state(tap_state_t s)
+{
+  return (s == TAP_RESET) || (s == TAP_IDLE) ||
+    (s == TAP_DRPAUSE) || (s == TAP_IRPAUSE);
+}
+
+static svf_status_t svf_parse_scan(svf_scan_t *s)
+{
+  char tok[SVF_TOKEN_SIZE];
+  char *end;
+  uint32_t len;
+  svf_token_t t;
+
+  if (svf_token(tok) != TOK_WORD) return SVF_ERROR;
+  len = strtoul(tok, &end, 10);
+  if (*end || len > s->max_len) return SVF_ERROR;
+
+  if (len != s->len) {
+    s->len = len;
+    svf_set_ones(s->mask, len);
+    memset(s->tdi, 0, SVF_BYTES(len));
+  }
+  s->check = false;
+
+  while ((t = svf_token(tok)) == TOK_WORD) {
+    uint8_t *dst;
+
+    if (!strcasecmp(tok, "TDI")) {
+      dst = s->tdi;
+    } else if (!strcasecmp(tok, "TDO")) {
+      dst = s->tdo;
+      s->check = true;
+    } else if (!strcasecmp(tok, "MASK")) {
+      dst = s->mask;
+    } else if (!strcasecmp(tok, "SMASK")) {
+      dst = NULL;
+    } else {
+      return SVF_ERROR;
+    }
+    if (svf_token(tok) != TOK_HEX) return SVF_ERROR;
+    if (dst) svf_hex_to_bits(dst, len);
+  }
+  return (t == TOK_SEMI) ? SVF_OK : SVF_ERROR;
+}
+
+static bool svf_shift_part(const pio_jtag_inst_t *jtag, const svf_scan_t *s, bool exit)
+{
+  if (s->len == 0) return true;
+  tap_shift_bits(jtag, s->tdi, s->check ? svf_rd : NULL, s->len, exit);
+  if (s->check) {
+    for (uint32_t i = 0; i < (s->len + 7) / 8; i++) {
+      if ((svf_rd[i] ^ s->tdo[i]) & s->mask[i]) return false;
+    }
+  }
+  return true;
+}
+
+static svf_status_t svf_scan(const pio_jtag_inst_t *jtag, bool ir)
+{
+  const svf_scan_t *h = ir ? &hir : &hdr;
+  const svf_scan_t *d = ir ? &sir : &sdr;
+  const svf_scan_t *t = ir ? &tir : &tdr;
+  bool ok = true;
+
+  if (h->len + d->len + t->len == 0) return SVF_OK;
+
+  tap_goto(jtag, ir ? TAP_IRSHIFT : TAP_DRSHIFT);
+  ok &= svf_shift_part(jtag, h, (d->len == 0) && (t->len == 0));
+  ok &= svf_shift_part(jtag, d, t->len == 0);
+  ok &= svf_shift_part(jtag, t, true);
+  tap_goto(jtag, ir ? svf_endir : svf_enddr);
+
+  return ok ? SVF_OK : SVF_MISMATCH;
+}
+
+/* Collect the remaining words of the statement */
+static int svf_words(char toks[][SVF_TOKEN_SIZE])
+{
+  int n = 0;
+  svf_token_t t;
+
+  while ((t = svf_token(toks[n])) == TOK_WORD) {
+    if (++n == SVF_MAX_TOKENS) return -1;
+  }
+  return (t == TOK_SEMI) ? n : -1;
+}
+
+static void svf_delay(float sec)
+{
+  uint32_t us = (uint32_t)(sec * 1e6f);
+
+  if (us >= 1000) {
+    vTaskDelay((us + 999) / 1000 / portTICK_PERIOD_MS);
+  } else if (us) {
+    busy_wait_us_32(us);
+  }
+}
+
+static svf_status_t svf_runtest(const pio_jtag_inst_t *jtag, char toks[][SVF_TOKEN_SIZE], int n)
+{
+  int i = 0;
+  uint32_t count = 0;
+  float min_time = 0.0f;
+  tap_state_t s;
+
+  if ((i < n) && ((s = tap_state_by_name(toks[i])) != TAP_UNKNOWN)) {
+    if (!svf_stable_state(s)) return SVF_ERROR;
+    svf_run_state = svf_run_end_state = s;
+    i++;
+  }
+  if ((i + 1 < n) && !strcasecmp(toks[i + 1], "TCK")) {
+    count = (uint32_t)strtof(toks[i], NULL);
+    i += 2;
+  } else if ((i + 1 < n) && !strcasecmp(toks[i + 1], "SCK")) {
+    i += 2;
+  }
+  if ((i + 1 < n) && !strcasecmp(toks[i + 1], "SEC")) {
+    min_time = strtof(toks[i], NULL);
+    i += 2;
+  }
+  if ((i + 2 < n) && !strcasecmp(toks[i], "MAXIMUM")) {
+    i += 3;
+  }
+  if ((i + 1 < n) && !strcasecmp(toks[i], "ENDSTATE")) {
+    s = tap_state_by_name(toks[i + 1]);
+    if (!svf_stable_state(s)) return SVF_ERROR;
+    svf_run_end_state = s;
+    i += 2;
+  }
+  if (i != n) return SVF_ERROR;
+
+  tap_goto(jtag, svf_run_state);
+  tap_run(jtag, count);
+  svf_delay(min_time);
+  tap_goto(jtag, svf_run_end_state);
+  return SVF_OK;
+}
+
+static svf_status_t svf_statement(const pio_jtag_inst_t *jtag, const char *cmd)
+{
+  static char toks[SVF_MAX_TOKENS][SVF_TOKEN_SIZE];
+  svf_status_t st;
+  tap_state_t s;
+  int n;
+
+  if (!strcasecmp(cmd, "SIR")) {
+    if ((st = svf_parse_scan(&sir)) != SVF_OK) return st;
+    return svf_scan(jtag, true);
+  }
+  if (!strcasecmp(cmd, "SDR")) {
+    if ((st = svf_parse_scan(&sdr)) != SVF_OK) return st;
+    return svf_scan(jtag, false);
+  }
+  if (!strcasecmp(cmd, "HIR")) return svf_parse_scan(&hir);
+  if (!strcasecmp(cmd, "HDR")) return svf_parse_scan(&hdr);
+  if (!strcasecmp(cmd, "TIR")) return svf_parse_scan(&tir);
+  if (!strcasecmp(cmd, "TDR")) return svf_parse_scan(&tdr);
+
+  if ((n = svf_words(toks)) < 0) return SVF_ERROR;
+
+  if (!strcasecmp(cmd, "RUNTEST")) {
+    return svf_runtest(jtag, toks, n);
+  } else if (!strcasecmp(cmd, "STATE")) {
+    for (int i = 0; i < n; i++) {
+      if ((s = tap_state_by_name(toks[i])) == TAP_UNKNOWN) return SVF_ERROR;
+      tap_goto(jtag, s);
+    }
+    return (n > 0 && svf_stable_state(tap_get_state())) ? SVF_OK : SVF_ERROR;
+  } else if (!strcasecmp(cmd, "ENDIR") || !strcasecmp(cmd, "ENDDR")) {
+    if (n != 1) return SVF_ERROR;
+    s = tap_state_by_name(toks[0]);
+    if (!svf_stable_state(s)) return SVF_ERROR;
+    if (cmd[3] == 'I' || cmd[3] == 'i') {
+      svf_endir = s;
+    } else {
+      svf_enddr = s;
+    }
+    return SVF_OK;
+  } else if (!strcasecmp(cmd, "FREQUENCY")) {
+    uint khz = 1000; /* default TCK frequency */
+    if (n == 2 && !strcasecmp(toks[1], "HZ")) {
+      khz = (uint)(strtof(toks[0], NULL) / 1000.0f);
+      if (khz == 0) khz = 1;
+    } else if (n != 0) {
+      return SVF_ERROR;
+    }
+    jtag_set_clk_freq(jtag, khz);
+    return SVF_OK;
+  } else if (!strcasecmp(cmd, "TRST")) {
+    return SVF_OK;
+  }
+  return SVF_ERROR;
+}
+
+static void svf_reply(const char *result, uint32_t n)
+{
+  char line[24];
+
+  snprintf(line, sizeof(line), "%s %lu\n", result, (unsigned long)n);
+  tud_cdc_n_write_str(CDC_JTAG, line);
+  tud_cdc_n_write_flush(CDC_JTAG);
+}
+
+static void svf_play(const pio_jtag_inst_t *jtag)
+{
+  char cmd[SVF_TOKEN_SIZE];
+  uint32_t index = 0;
+  svf_status_t st = SVF_OK;
+  svf_token_t t;
+
+  svf_endir = svf_enddr = TAP_IDLE;
+  svf_run_state = svf_run_end_state = TAP_IDLE;
+  sir.len = sdr.len = 0;
+  hir.len = hdr.len = tir.len = tdr.len = 0;
+  tap_invalidate();
+  svf_input_lost = false;
+
+  while ((t = svf_token(cmd)) != TOK_EOF) {
+    if (t == TOK_SEMI) continue; /* empty statement */
+    index++;
+    st = (t == TOK_WORD) ? svf_statement(jtag, cmd) : SVF_ERROR;
+    if (st != SVF_OK) break;
+  }
+  /* end of input without EOT is not the end of file */
+  if (svf_input_lost) st = SVF_ERROR;
+
+  if (st == SVF_OK) {
+    svf_reply("PASS", index);
+  } else {
+    if (st == SVF_ERROR) svf_skip_statement();
+    svf_skip_to_eot();
+    svf_reply((st == SVF_MISMATCH) ? "FAIL" : "ERROR", index);
+  }
+}
+
+static void svf_task(__unused void *params)
+{
+  pio_jtag_inst_t *jtag;
+  uint8_t c;
+
+  while(1) {
+    if (tud_cdc_n_connected(CDC_JTAG)) {
+      if (tud_cdc_n_available(CDC_JTAG)) {
+        jtag = gmm7550_jtag_acquire();
+        if (svf_unget < 0 && svf_in_pos == svf_in_len &&
+            tud_cdc_n_peek(CDC_JTAG, &c) && c == JCFG_SOH) {
+          gmm7550_jcfg_load(jtag);
+        } else {
+          svf_play(jtag);
+        }
+        gmm7550_jtag_release();
+      }
+    } else {
+      svf_in_pos = svf_in_len = 0;
+      svf_unget = -1;
+    }
+    vTaskDelay(1);
+  }
+}
+
+void gmm7550_svf_init(void)
+{
+  xTaskCreate(svf_task, "SVF",
+              2 * configMINIMAL_STACK_SIZE,
+              NULL,
+              (tskIDLE_PRIORITY + 2UL),
+              NULL
+              );
+}
@@ -1,5 +1,34 @@
 #include "gmm7550_control.h"
 #include "tusb.h"
+#include "device/usbd_pvt.h"
+
+/* Bus reset: DirtyJTAG interface and the CDC rings */
+static void app_reset(uint8_t rhport)
+{
+  djtag_itf_reset(rhport);
+  for (uint8_t i = 0; i < CFG_TUD_CDC; i++) cdcbuf_clear(i);
+}
+
+/* Application class drivers for the interfaces not handled by TinyUSB */
+static const usbd_class_driver_t app_drivers[] = {
+  {
+#if CFG_TUSB_DEBUG >= 2
+    .name            = "DJTAG",
+#endif
+    .init            = djtag_itf_init,
+    .reset           = app_reset,
+    .open            = djtag_itf_open,
+    .control_xfer_cb = djtag_itf_control_xfer_cb,
+    .xfer_cb         = djtag_itf_xfer_cb,
+    .sof             = NULL
+  },
+};
+
+usbd_class_driver_t const *usbd_app_driver_get_cb(uint8_t *driver_count)
+{
+  *driver_count = sizeof(app_drivers) / sizeof(app_drivers[0]);
+  return app_drivers;
+}
 
 static void usb_init(__unused void *params)
 {
@@ -15,13 +44,18 @@ static void auto_start(void)
   gmm7550_on();
   gmm7550_hreset(0);
   vTaskDelay(100 / portTICK_PERIOD_MS);
+  gmm7550_i2c_acquire();
   gmm7550_i2c_gpio_init();
   gmm7550_sreset(1);
   pca_write_reg(3, 0x40); /* Connect UART Rx/Tx signals, Configuration Mode = 0 (SPI Active) */
   vTaskDelay(GMM7550_MR_TIME_MS / portTICK_PERIOD_MS);
   gmm7550_sreset(0);
+  gmm7550_i2c_release();
 }
 
+static void board_task(void *params);
+static TaskHandle_t board_task_handle;
+
 void usb_task(__unused void *params)
 {
   usb_init(NULL);
@@ -33,6 +67,12 @@ void usb_task(__unused void *params)
               (tskIDLE_PRIORITY + 2UL),
               NULL
               );
+  xTaskCreate(board_task, "Board",
+              configMINIMAL_STACK_SIZE,
+              NULL,
+              (tskIDLE_PRIORITY + 2UL),
+              &board_task_handle
+              );
 
   while(1) {
     uint8_t buf[SERIAL_BUFFER_SIZE];
@@ -80,7 +120,140 @@ void tud_cdc_line_coding_cb(uint8_t itf, cdc_line_coding_t const* p_line_coding)
 
 void tud_cdc_line_state_cb(uint8_t itf, bool dtr, bool rts)
 {
+  if (!dtr) cdcbuf_clear(itf); /* port closed by the host */
   if (CDC_SPI == itf) {
-    gmm7550_spi_set_cs(rts);
+    gmm7550_spi_bridge_cs(rts);
+  }
+}
+
+void tud_umount_cb(void)
+{
+  for (uint8_t i = 0; i < CFG_TUD_CDC; i++) cdcbuf_clear(i);
+}
+
+/* Board control requests (GMM7550_VREQ_STATE..CFG) take tens of
+ * milliseconds and wait for the I2C bus, they are executed by the
+ * board task.  The data stage is NAKed until the task has the reply,
+ * then it is started by the USB device task (TinyUSB is not thread
+ * safe); one request at a time, others are stalled. */
+static tusb_control_request_t board_request;
+static uint8_t board_rhport;
+static uint8_t board_reply[4];
+static volatile bool board_busy = false;
+
+/* Data stage of the board request, called by the USB device task */
+static void board_request_done(__unused void *param)
+{
+  tud_control_xfer(board_rhport, &board_request, board_reply, sizeof(board_reply));
+  board_busy = false;
+}
+
+static void board_request_run(const tusb_control_request_t *request)
+{
+  const uint16_t arg = request->wValue;
+  uint8_t status = GMM7550_VREQ_OK;
+  uint8_t state = 0;
+  uint8_t port1 = 0;
+
+  switch (request->bRequest) {
+  case GMM7550_VREQ_POWER:
+    if (arg == 1) {
+      gmm7550_on();
+      vTaskDelay(100 / portTICK_PERIOD_MS);
+      gmm7550_hreset(0);
+    } else if (arg == 0) {
+      gmm7550_hreset(1);
+      gmm7550_off();
+    } else {
+      status = GMM7550_VREQ_EINVAL;
+    }
+    break;
+  case GMM7550_VREQ_HRESET:
+    if (arg > 2) {
+      status = GMM7550_VREQ_EINVAL;
+    } else {
+      gmm7550_hreset(arg);
+    }
+    break;
+  case GMM7550_VREQ_SRESET:
+  case GMM7550_VREQ_MUX:
+  case GMM7550_VREQ_CFG:
+    if (arg > (request->bRequest == GMM7550_VREQ_SRESET ? 2 : 0x0f)) {
+      status = GMM7550_VREQ_EINVAL;
+    } else if (!gmm7550_is_ready()) {
+      status = GMM7550_VREQ_EOFF;
+    } else if (request->bRequest == GMM7550_VREQ_SRESET) {
+      gmm7550_sreset(arg);
+    } else if (!(request->bRequest == GMM7550_VREQ_MUX ?
+                 gmm7550_set_mux(arg) : gmm7550_set_cfg(arg))) {
+      status = GMM7550_VREQ_EUNSAFE;
+    }
+    break;
+  default: /* GMM7550_VREQ_STATE */
+    break;
+  }
+
+  if (gpio_get_out_level(GMM7550_EN_PIN)) state |= GMM7550_STATE_ON;
+  if (gpio_get_out_level(GMM7550_MR_PIN)) state |= GMM7550_STATE_HRESET;
+  gmm7550_i2c_acquire();
+  if (gmm7550_is_ready() && i2c_gpio_initialized) {
+    state |= GMM7550_STATE_I2C;
+    if (!(pca_read_reg(2) & 0x01)) state |= GMM7550_STATE_SRESET;
+    port1 = pca_read_reg(3);
+  }
+  gmm7550_i2c_release();
+  board_reply[0] = status;
+  board_reply[1] = state;
+  board_reply[2] = port1;
+  board_reply[3] = 0;
+  usbd_defer_func(board_request_done, NULL, false);
+}
+
+static void board_task(__unused void *params)
+{
+  while (1) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    board_request_run(&board_request);
+  }
+}
+
+static bool board_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_request_t const *request)
+{
+  if (stage != CONTROL_STAGE_SETUP) return true;
+  if (request->bmRequestType_bit.direction != TUSB_DIR_IN) return false;
+  if (board_busy || !board_task_handle) return false;
+
+  board_request = *request;
+  board_rhport = rhport;
+  board_busy = true;
+  xTaskNotifyGive(board_task_handle);
+  return true;
+}
+
+/* Vendor requests of all interfaces and the device come here */
+bool tud_vendor_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_request_t const *request)
+{
+  switch (request->bRequest) {
+  case GMM7550_VREQ_USBSTAT:
+    return usbstat_control_xfer_cb(rhport, stage, request);
+  case GMM7550_VREQ_PROFILE:
+    return profile_control_xfer_cb(rhport, stage, request);
+#if GMM7550_USB_BENCH
+  case GMM7550_VREQ_BENCH:
+    return djtag_bench_control_xfer_cb(rhport, stage, request);
+#endif
+  case GMM7550_VREQ_STATE:
+  case GMM7550_VREQ_POWER:
+  case GMM7550_VREQ_HRESET:
+  case GMM7550_VREQ_SRESET:
+  case GMM7550_VREQ_MUX:
+  case GMM7550_VREQ_CFG:
+    return board_control_xfer_cb(rhport, stage, request);
+  default:
+#if GMM7550_MPSSE
+    return mpsse_control_xfer_cb(rhport, stage, request);
+#else
+    return false;
+#endif
   }
 }
@@ -25,6 +25,7 @@
 
 #include "bsp/board_api.h"
 #include "tusb.h"
+#include "gmm7550_control.h"
 
 /* Pretend it is DirtyJTAG
  */
@@ -49,7 +50,11 @@ tusb_desc_device_t const desc_device = {
 
     .idVendor           = USB_VID,
     .idProduct          = USB_PID,
+#if GMM7550_MPSSE
+    .bcdDevice          = 0x0700, // FT2232H, for MPSSE host tools
+#else
     .bcdDevice          = 0x0200,
+#endif
 
     .iManufacturer      = 0x01,
     .iProduct           = 0x02,
@@ -70,21 +75,46 @@ uint8_t const *tud_descriptor_device_cb(void) {
 
 enum {
   ITF_NUM_PROBE = 0,
+#if GMM7550_MPSSE
+  ITF_NUM_MPSSE,      // must be interface 1 (FTDI channel B)
+#endif
   ITF_NUM_CDC_0,
   ITF_NUM_CDC_0_DATA,
   ITF_NUM_CDC_1,
   ITF_NUM_CDC_1_DATA,
   ITF_NUM_CDC_2,
   ITF_NUM_CDC_2_DATA,
+  ITF_NUM_CDC_3,
+  ITF_NUM_CDC_3_DATA,
+  ITF_NUM_CDC_4,
+  ITF_NUM_CDC_4_DATA,
+  ITF_NUM_CDC_5,
+  ITF_NUM_CDC_5_DATA,
+#if GMM7550_MSC
+  ITF_NUM_MSC,
+#endif
+#if GMM7550_DFU
+  ITF_NUM_DFU,
+#endif
   ITF_NUM_TOTAL
 };
 
 #define EPNUM_PROBE_OUT     0x01
 #define EPNUM_PROBE_IN      0x82
 
+#if GMM7550_MPSSE
+// FTDI channel B endpoints, hard-coded in libftdi
+#define EPNUM_MPSSE_OUT     0x04
+#define EPNUM_MPSSE_IN      0x83
+
+#define EPNUM_CDC_0_NOTIF   0x8B
+#define EPNUM_CDC_0_OUT     0x0C
+#define EPNUM_CDC_0_IN      0x8C
+#else
 #define EPNUM_CDC_0_NOTIF   0x83
 #define EPNUM_CDC_0_OUT     0x04
 #define EPNUM_CDC_0_IN      0x84
+#endif
 
 #define EPNUM_CDC_1_NOTIF   0x85
 #define EPNUM_CDC_1_OUT     0x06
@@ -94,7 +124,68 @@ enum {
 #define EPNUM_CDC_2_OUT     0x08
 #define EPNUM_CDC_2_IN      0x88
 
-#define CONFIG_TOTAL_LEN    (TUD_CONFIG_DESC_LEN + TUD_VENDOR_DESC_LEN + TUD_CDC_DESC_LEN * CFG_TUD_CDC)
+#define EPNUM_CDC_3_NOTIF   0x89
+#define EPNUM_CDC_3_OUT     0x0A
+#define EPNUM_CDC_3_IN      0x8A
+
+#define EPNUM_CDC_4_NOTIF   0x8D
+#define EPNUM_CDC_4_OUT     0x0E
+#define EPNUM_CDC_4_IN      0x8E
+
+// IN 1 is free, the notification endpoint is never used anyway
+#define EPNUM_CDC_5_NOTIF   0x81
+#define EPNUM_CDC_5_OUT     0x0F
+#define EPNUM_CDC_5_IN      0x8F
+
+#if GMM7550_MSC
+// The only IN endpoint left free by CDC 0
+#define EPNUM_MSC_OUT       0x03
+#if GMM7550_MPSSE
+#define EPNUM_MSC_IN        0x84
+#else
+#define EPNUM_MSC_IN        0x8B
+#endif
+#endif
+
+#if GMM7550_MPSSE
+// Same as TUD_VENDOR_DESCRIPTOR(), but subclass and protocol are 0xFF as in FT2232H
+#define TUD_MPSSE_DESCRIPTOR(_itfnum, _stridx, _epout, _epin, _epsize) \
+  9, TUSB_DESC_INTERFACE, _itfnum, 0, 2, TUSB_CLASS_VENDOR_SPECIFIC, 0xFF, 0xFF, _stridx,\
+  7, TUSB_DESC_ENDPOINT, _epout, TUSB_XFER_BULK, U16_TO_U8S_LE(_epsize), 0,\
+  7, TUSB_DESC_ENDPOINT, _epin, TUSB_XFER_BULK, U16_TO_U8S_LE(_epsize), 0
+
+#define CONFIG_VENDOR_LEN   (2 * TUD_VENDOR_DESC_LEN)
+#else
+#define CONFIG_VENDOR_LEN   TUD_VENDOR_DESC_LEN
+#endif
+
+#if GMM7550_MSC
+#define CONFIG_MSC_LEN      TUD_MSC_DESC_LEN
+#if GMM7550_MPSSE
+#define STRID_MSC           12
+#else
+#define STRID_MSC           11
+#endif
+#else
+#define CONFIG_MSC_LEN      0
+#endif
+
+#if GMM7550_DFU
+#define CONFIG_DFU_LEN      TUD_DFU_DESC_LEN(1)
+#if GMM7550_MSC
+#define STRID_DFU           (STRID_MSC + 1)
+#elif GMM7550_MPSSE
+#define STRID_DFU           12
+#else
+#define STRID_DFU           11
+#endif
+// Downloads are written in the USB device task, no detach is needed
+#define DFU_ATTRS           (DFU_ATTR_CAN_DOWNLOAD | DFU_ATTR_MANIFESTATION_TOLERANT)
+#else
+#define CONFIG_DFU_LEN      0
+#endif
+
+#define CONFIG_TOTAL_LEN    (TUD_CONFIG_DESC_LEN + CONFIG_VENDOR_LEN + TUD_CDC_DESC_LEN * CFG_TUD_CDC + CONFIG_MSC_LEN + CONFIG_DFU_LEN)
 
 uint8_t const desc_fs_configuration[] =
 {
@@ -102,11 +193,44 @@ uint8_t const desc_fs_configuration[] =
   TUD_CONFIG_DESCRIPTOR(1, ITF_NUM_TOTAL, 0, CONFIG_TOTAL_LEN, 0x00, 500),
 
   TUD_VENDOR_DESCRIPTOR(ITF_NUM_PROBE, 4, EPNUM_PROBE_OUT, EPNUM_PROBE_IN, 64),
+#if GMM7550_MPSSE
+  TUD_MPSSE_DESCRIPTOR(ITF_NUM_MPSSE, 11, EPNUM_MPSSE_OUT, EPNUM_MPSSE_IN, 64),
+#endif
   // Interface number, string index, EP notification address and size, EP data address (out, in) and size.
   TUD_CDC_DESCRIPTOR(ITF_NUM_CDC_0, 5, EPNUM_CDC_0_NOTIF, 8, EPNUM_CDC_0_OUT, EPNUM_CDC_0_IN, 64),
   TUD_CDC_DESCRIPTOR(ITF_NUM_CDC_1, 6, EPNUM_CDC_1_NOTIF, 8, EPNUM_CDC_1_OUT, EPNUM_CDC_1_IN, 64),
   TUD_CDC_DESCRIPTOR(ITF_NUM_CDC_2, 7, EPNUM_CDC_2_NOTIF, 8, EPNUM_CDC_2_OUT, EPNUM_CDC_2_IN, 64),
+  TUD_CDC_DESCRIPTOR(ITF_NUM_CDC_3, 8, EPNUM_CDC_3_NOTIF, 8, EPNUM_CDC_3_OUT, EPNUM_CDC_3_IN, 64),
+  TUD_CDC_DESCRIPTOR(ITF_NUM_CDC_4, 9, EPNUM_CDC_4_NOTIF, 8, EPNUM_CDC_4_OUT, EPNUM_CDC_4_IN, 64),
+  TUD_CDC_DESCRIPTOR(ITF_NUM_CDC_5, 10, EPNUM_CDC_5_NOTIF, 8, EPNUM_CDC_5_OUT, EPNUM_CDC_5_IN, 64),
+#if GMM7550_MSC
+  TUD_MSC_DESCRIPTOR(ITF_NUM_MSC, STRID_MSC, EPNUM_MSC_OUT, EPNUM_MSC_IN, 64),
+#endif
+#if GMM7550_DFU
+  // Interface number, alternate count, string index, attributes, detach timeout, transfer size
+  TUD_DFU_DESCRIPTOR(ITF_NUM_DFU, 1, STRID_DFU, DFU_ATTRS, 1000, CFG_TUD_DFU_XFER_BUFSIZE),
+#endif
+};
+
+// Data endpoints of the interfaces, for the traffic counters (usbstat.c)
+// Order: USB_CHANNEL_PROBE, USB_CHANNEL_CDC(0..5), others
+const usb_channel_t usb_channels[] = {
+  { "DJTAG",   EPNUM_PROBE_OUT, EPNUM_PROBE_IN },
+  { "serial",  EPNUM_CDC_0_OUT, EPNUM_CDC_0_IN },
+  { "CLI",     EPNUM_CDC_1_OUT, EPNUM_CDC_1_IN },
+  { "SPI",     EPNUM_CDC_2_OUT, EPNUM_CDC_2_IN },
+  { "JTAG",    EPNUM_CDC_3_OUT, EPNUM_CDC_3_IN },
+  { "XVC",     EPNUM_CDC_4_OUT, EPNUM_CDC_4_IN },
+  { "pipe",    EPNUM_CDC_5_OUT, EPNUM_CDC_5_IN },
+#if GMM7550_MPSSE
+  { "MPSSE",   EPNUM_MPSSE_OUT, EPNUM_MPSSE_IN },
+#endif
+#if GMM7550_MSC
+  { "MSC",     EPNUM_MSC_OUT,   EPNUM_MSC_IN },
+#endif
+  { "control", 0x00, 0x80 },
 };
+const uint usb_n_channels = sizeof(usb_channels) / sizeof(usb_channels[0]);
 
 // Invoked when received GET CONFIGURATION DESCRIPTOR
 // Application return pointer to descriptor
@@ -140,6 +264,18 @@ char const *string_desc_arr[] =
   "GMM-7550 serial",             // 5: CDC Interface
   "Control CLI",                 // 6: CDC Interface
   "GMM-7550 SPI",                // 7: CDC Interface
+  "GMM-7550 JTAG",               // 8: CDC Interface
+  "GMM-7550 XVC",                // 9: CDC Interface
+  "GMM-7550 JTAG pipe",          // 10: CDC Interface
+#if GMM7550_MPSSE
+  "MPSSE JTAG",                  // 11: Vendor interface (FTDI MPSSE)
+#endif
+#if GMM7550_MSC
+  "GMM-7550 drag-and-drop",      // 11 or 12: Mass storage interface
+#endif
+#if GMM7550_DFU
+  "RP2040 firmware",             // 11..13: DFU interface, alternate setting 0
+#endif
 };
 
 static uint16_t _desc_str[32 + 1];
@@ -0,0 +1,243 @@
+/*
+ * Raspberry Pi RP2040 Control firmware for GMM-7550 module
+ * https://www.gmm7550.dev/doc/rp2040.html
+ *
+ * Copyright (c) 2026 Anton Kuzmin <ak@gmm7550.dev>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* USB traffic counters, per endpoint.
+ *
+ * Completed transfers and endpoint stalls are counted on the way from
+ * the device controller driver to the TinyUSB stack: dcd_event_handler()
+ * and dcd_edpt_stall() are wrapped by the linker (--wrap, see
+ * CMakeLists.txt), so every interface is covered without changes in
+ * the class drivers.  CDC writes which did not fit into the TX FIFO or
+ * ring are caught in the tud_cdc_n_write() wrapper (cdcbuf.c).
+ *
+ * Buffer-full events are the back-pressure seen by a channel: OUT
+ * endpoint left idle after a packet because there is no room for the
+ * next one (the host is NAKed), or IN data which had to wait for free
+ * space in the transmit buffer.  They are reported with usbstat_full().
+ *
+ * Counters are 32-bit and wrap around, rates are computed from the
+ * differences, so that is harmless.
+ */
+
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "gmm7550_control.h"
+#include "tusb.h"
+#include "device/dcd.h"
+#include "FreeRTOS_CLI.h"
+
+#define USBSTAT_MPS 64 /* full speed bulk and control endpoints */
+
+typedef struct {
+  uint32_t bytes;
+  uint32_t packets;
+  uint32_t short_packets;
+  uint32_t stalls;
+  uint32_t full;
+} ep_stat_t;
+
+/* [direction][endpoint number] */
+static ep_stat_t ep_stat[2][16];
+static uint32_t bus_resets;
+static uint32_t stat_reset_time;
+
+static inline ep_stat_t *ep_stat_get(uint8_t ep_addr)
+{
+  return &ep_stat[tu_edpt_dir(ep_addr)][tu_edpt_number(ep_addr)];
+}
+
+void usbstat_full(uint8_t ep_addr)
+{
+  ep_stat_get(ep_addr)->full++;
+}
+
+static void usbstat_reset(void)
+{
+  memset(ep_stat, 0, sizeof(ep_stat));
+  bus_resets = 0;
+  stat_reset_time = time_us_32();
+}
+
+extern void __real_dcd_event_handler(dcd_event_t const *event, bool in_isr);
+
+void __wrap_dcd_event_handler(dcd_event_t const *event, bool in_isr)
+{
+  ep_stat_t *s;
+  uint32_t len;
+
+  switch (event->event_id) {
+  case DCD_EVENT_XFER_COMPLETE:
+    s = ep_stat_get(event->xfer_complete.ep_addr);
+    len = event->xfer_complete.len;
+    s->bytes += len;
+    s->packets += len / USBSTAT_MPS;
+    /* a transfer ends with a short (or zero length) packet, or when
+     * the requested length is done */
+    if (len % USBSTAT_MPS || len == 0) {
+      s->packets++;
+      s->short_packets++;
+    }
+    break;
+  case DCD_EVENT_BUS_RESET:
+    bus_resets++;
+    break;
+  default:
+    break;
+  }
+  __real_dcd_event_handler(event, in_isr);
+}
+
+extern void __real_dcd_edpt_stall(uint8_t rhport, uint8_t ep_addr);
+
+void __wrap_dcd_edpt_stall(uint8_t rhport, uint8_t ep_addr)
+{
+  ep_stat_get(ep_addr)->stalls++;
+  __real_dcd_edpt_stall(rhport, ep_addr);
+}
+
+/* GMM7550_VREQ_USBSTAT reply, little endian:
+ *   u8  version (1)
+ *   u8  number of channels
+ *   u8  counters per endpoint (5)
+ *   u8  reserved
+ *   u32 microseconds since the counters reset
+ *   u32 bus resets
+ * then for every channel (usb_channels[] order):
+ *   char[8] name, NUL padded
+ *   u32 x 5 OUT endpoint: bytes, packets, short packets, stalls, buffer-full events
+ *   u32 x 5 IN endpoint, the same
+ * wValue = 1 resets the counters after the reply is made.
+ */
+#define USBSTAT_VERSION     1
+#define USBSTAT_HDR_SIZE    12
+#define USBSTAT_NAME_SIZE   8
+#define USBSTAT_CHAN_SIZE   (USBSTAT_NAME_SIZE + 2 * sizeof(ep_stat_t))
+#define USBSTAT_MAX_CHANNELS 10
+
+bool usbstat_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_request_t const *request)
+{
+  static uint8_t reply[USBSTAT_HDR_SIZE + USBSTAT_MAX_CHANNELS * USBSTAT_CHAN_SIZE];
+  uint8_t *p = reply;
+  uint32_t t;
+  uint n = MIN(usb_n_channels, USBSTAT_MAX_CHANNELS);
+
+  if (stage != CONTROL_STAGE_SETUP) return true;
+  if (request->bmRequestType_bit.direction != TUSB_DIR_IN) return false;
+
+  *p++ = USBSTAT_VERSION;
+  *p++ = n;
+  *p++ = sizeof(ep_stat_t) / sizeof(uint32_t);
+  *p++ = 0;
+  t = time_us_32() - stat_reset_time;
+  memcpy(p, &t, 4); p += 4;
+  memcpy(p, &bus_resets, 4); p += 4;
+  for (uint c = 0; c < n; c++) {
+    memset(p, 0, USBSTAT_NAME_SIZE);
+    strncpy((char *)p, usb_channels[c].name, USBSTAT_NAME_SIZE);
+    p += USBSTAT_NAME_SIZE;
+    memcpy(p, ep_stat_get(usb_channels[c].ep_out), sizeof(ep_stat_t));
+    p += sizeof(ep_stat_t);
+    memcpy(p, ep_stat_get(usb_channels[c].ep_in), sizeof(ep_stat_t));
+    p += sizeof(ep_stat_t);
+  }
+  if (request->wValue == 1) usbstat_reset();
+
+  return tud_control_xfer(rhport, request, reply, p - reply);
+}
+
+/* Per second rate of a counter over dt microseconds */
+static unsigned long usbstat_rate(uint32_t delta, uint32_t dt)
+{
+  return dt ? (unsigned long)((uint64_t)delta * 1000000 / dt) : 0;
+}
+
+#define USBSTAT_SHORT_HELP "usbstat [r]\n"
+
+static BaseType_t cli_usbstat(char *pcWriteBuffer,
+                              size_t xWriteBufferLen,
+                              const char *pcCmd)
+{
+  /* rates are computed since the previous 'usbstat' */
+  static uint32_t last_time;
+  static uint32_t last_bytes[2][16];
+  static uint32_t last_packets[2][16];
+  static uint32_t now;
+  static uint line = 0;
+  const ep_stat_t *s;
+  uint8_t ep;
+  uint dir, num;
+  char *p;
+  BaseType_t p_len;
+
+  if (line == 0) {
+    p = (char *)FreeRTOS_CLIGetParameter(pcCmd, 1, &p_len);
+    if (p) {
+      if (p_len == 1 && *p == 'r') {
+        usbstat_reset();
+        memset(last_bytes, 0, sizeof(last_bytes));
+        memset(last_packets, 0, sizeof(last_packets));
+        last_time = stat_reset_time;
+        *pcWriteBuffer = '\0';
+      } else {
+        strncpy(pcWriteBuffer, "usbstat command argument should be 'r'\n", xWriteBufferLen);
+      }
+      return pdFALSE;
+    }
+    now = time_us_32();
+    snprintf(pcWriteBuffer, xWriteBufferLen,
+             "USB traffic: %lu ms since reset, rates over %lu ms, %lu bus reset(s)\n"
+             "channel dir      bytes  packets    short stall     full      B/s  pkt/s\n",
+             (unsigned long)((now - stat_reset_time) / 1000),
+             (unsigned long)((now - last_time) / 1000),
+             (unsigned long)bus_resets);
+  } else {
+    dir = (line - 1) & 1;
+    ep = dir ? usb_channels[(line - 1) / 2].ep_in : usb_channels[(line - 1) / 2].ep_out;
+    num = tu_edpt_number(ep);
+    s = ep_stat_get(ep);
+    snprintf(pcWriteBuffer, xWriteBufferLen,
+             "%-7s %-3s %10lu %8lu %8lu %5lu %8lu %8lu %6lu\n",
+             dir ? "" : usb_channels[(line - 1) / 2].name,
+             dir ? "IN" : "OUT",
+             (unsigned long)s->bytes, (unsigned long)s->packets,
+             (unsigned long)s->short_packets, (unsigned long)s->stalls,
+             (unsigned long)s->full,
+             usbstat_rate(s->bytes - last_bytes[dir][num], now - last_time),
+             usbstat_rate(s->packets - last_packets[dir][num], now - last_time));
+  }
+
+  if (line++ < 2 * usb_n_channels) return pdTRUE;
+
+  for (uint c = 0; c < usb_n_channels; c++) {
+    for (dir = 0; dir < 2; dir++) {
+      ep = dir ? usb_channels[c].ep_in : usb_channels[c].ep_out;
+      num = tu_edpt_number(ep);
+      last_bytes[dir][num] = ep_stat_get(ep)->bytes;
+      last_packets[dir][num] = ep_stat_get(ep)->packets;
+    }
+  }
+  last_time = now;
+  line = 0;
+  return pdFALSE;
+}
+
+static const CLI_Command_Definition_t usbstat_cmd = {
+  "usbstat",
+  USBSTAT_SHORT_HELP
+  "  USB traffic counters and rates (since the previous usbstat)\n"
+  "  per interface and direction, 'r' -- reset\n\n",
+  cli_usbstat,
+  -1
+};
+
+void cli_register_usbstat(void)
+{
+  FreeRTOS_CLIRegisterCommand(&usbstat_cmd);
+}
@@ -0,0 +1,254 @@
+/*
+ * Raspberry Pi RP2040 Control firmware for GMM-7550 module
+ * https://www.gmm7550.dev/doc/rp2040.html
+ *
+ * Copyright (c) 2026 Anton Kuzmin <ak@gmm7550.dev>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* Xilinx Virtual Cable (XVC 1.0) server
+ *
+ * XVC commands are sent as is over the XVC CDC channel, the TCP side
+ * of the protocol is handled by the host (tools/gmm7550_xvc.py):
+ *   getinfo:                         -> "xvcServer_v1.0:<max vector bytes>\n"
+ *   settck:<period ns, LE32>         -> actual TCK period ns, LE32
+ *   shift:<bits, LE32><TMS><TDI>     -> TDO, (bits + 7) / 8 bytes
+ * Vectors are LSB first.  A run of bits with constant TMS, together
+ * with the next bit (TMS change), is shifted by a single PIO transfer.
+ */
+
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "gmm7550_control.h"
+#include "tusb.h"
+#include "pio_jtag.h"
+#include "tap.h"
+
+#define XVC_MAX_BYTES 2048
+#define XVC_CMD_SIZE  8 /* "getinfo:" */
+
+/* one spare byte for the unaligned access to the vectors */
+static uint8_t xvc_tms[XVC_MAX_BYTES + 1];
+static uint8_t xvc_tdi[XVC_MAX_BYTES + 1];
+static uint8_t xvc_tdo[XVC_MAX_BYTES + 1];
+
+/* single run in the PIO bit order (MSB first), spare word for 32-bit transfers */
+static uint8_t run_tdi[XVC_MAX_BYTES + 4] __aligned(4);
+static uint8_t run_tdo[XVC_MAX_BYTES + 4] __aligned(4);
+
+static bool xvc_read(uint8_t *buf, uint32_t len)
+{
+  uint32_t n;
+
+  while (len) {
+    if (!tud_cdc_n_connected(CDC_XVC)) return false;
+    n = tud_cdc_n_read(CDC_XVC, buf, len);
+    if (n == 0) {
+      vTaskDelay(1);
+      continue;
+    }
+    buf += n;
+    len -= n;
+  }
+  return true;
+}
+
+static bool xvc_write(const uint8_t *buf, uint32_t len)
+{
+  uint32_t n;
+
+  while (len) {
+    if (!tud_cdc_n_connected(CDC_XVC)) return false;
+    n = tud_cdc_n_write(CDC_XVC, buf, len);
+    if (n < len) {
+      tud_cdc_n_write_flush(CDC_XVC);
+      vTaskDelay(1);
+    }
+    buf += n;
+    len -= n;
+  }
+  tud_cdc_n_write_flush(CDC_XVC);
+  return true;
+}
+
+static bool xvc_read_u32(uint32_t *v)
+{
+  uint8_t b[4];
+
+  if (!xvc_read(b, sizeof(b))) return false;
+  *v = b[0] | (b[1] << 8) | (b[2] << 16) | ((uint32_t)b[3] << 24);
+  return true;
+}
+
+static bool xvc_write_u32(uint32_t v)
+{
+  uint8_t b[4] = {v, v >> 8, v >> 16, v >> 24};
+
+  return xvc_write(b, sizeof(b));
+}
+
+static inline bool xvc_bit(const uint8_t *v, uint32_t i)
+{
+  return (v[i >> 3] >> (i & 7)) & 1;
+}
+
+/* Number of bits with the same TMS value starting at pos */
+static uint32_t xvc_run_length(uint32_t pos, uint32_t nbits)
+{
+  const bool tms = xvc_bit(xvc_tms, pos);
+  const uint8_t same = tms ? 0xff : 0x00;
+  uint32_t i = pos + 1;
+
+  while (i < nbits) {
+    if (!(i & 7) && (i + 8 <= nbits) && (xvc_tms[i >> 3] == same)) {
+      i += 8;
+    } else if (xvc_bit(xvc_tms, i) == tms) {
+      i++;
+    } else {
+      break;
+    }
+  }
+  return i - pos;
+}
+
+/* Bits pos .. pos+len-1 of LSB first vector to MSB first bytes */
+static void xvc_gather(uint8_t *dst, const uint8_t *src, uint32_t pos, uint32_t len)
+{
+  const uint8_t *p = &src[pos >> 3];
+  const uint s = pos & 7;
+
+  for (uint32_t i = 0; i < (len + 7) / 8; i++) {
+    dst[i] = jtag_rev8((p[i] | (p[i + 1] << 8)) >> s);
+  }
+}
+
+/* Reverse of xvc_gather(), bits past len in src should be 0 */
+static void xvc_scatter(uint8_t *dst, const uint8_t *src, uint32_t pos, uint32_t len)
+{
+  uint8_t *p = &dst[pos >> 3];
+  const uint s = pos & 7;
+  uint16_t w;
+
+  for (uint32_t i = 0; i < (len + 7) / 8; i++) {
+    w = jtag_rev8(src[i]) << s;
+    p[i] |= w;
+    p[i + 1] |= w >> 8;
+  }
+}
+
+static void xvc_shift(const pio_jtag_inst_t *jtag, uint32_t nbits)
+{
+  uint32_t pos = 0, len;
+  bool tms, tms_last;
+
+  memset(xvc_tdo, 0, sizeof(xvc_tdo));
+  while (pos < nbits) {
+    len = xvc_run_length(pos, nbits);
+    tms = tms_last = xvc_bit(xvc_tms, pos);
+    if (pos + len < nbits) {
+      len++; /* TMS changes on the last bit */
+      tms_last = !tms;
+    }
+    xvc_gather(run_tdi, xvc_tdi, pos, len);
+    jtag_transfer_tms(jtag, len, tms, tms_last, run_tdi, run_tdo);
+    xvc_scatter(xvc_tdo, run_tdo, pos, len);
+    pos += len;
+  }
+}
+
+static bool xvc_cmd_shift(void)
+{
+  pio_jtag_inst_t *jtag;
+  uint32_t nbits, nbytes, n;
+
+  if (!xvc_read_u32(&nbits)) return false;
+  nbytes = (nbits + 7) / 8;
+
+  if (nbytes > XVC_MAX_BYTES) {
+    /* more than announced by getinfo:, keep the stream in sync */
+    memset(xvc_tdo, 0, sizeof(xvc_tdo));
+    for (uint32_t left = 2 * nbytes; left; left -= n) {
+      n = MIN(left, XVC_MAX_BYTES);
+      if (!xvc_read(xvc_tms, n)) return false;
+    }
+    for (uint32_t left = nbytes; left; left -= n) {
+      n = MIN(left, XVC_MAX_BYTES);
+      if (!xvc_write(xvc_tdo, n)) return false;
+    }
+    return true;
+  }
+
+  if (!xvc_read(xvc_tms, nbytes) || !xvc_read(xvc_tdi, nbytes)) return false;
+
+  jtag = gmm7550_jtag_acquire();
+  tap_invalidate();
+  xvc_shift(jtag, nbits);
+  gmm7550_jtag_release();
+
+  return xvc_write(xvc_tdo, nbytes);
+}
+
+static bool xvc_cmd_settck(void)
+{
+  pio_jtag_inst_t *jtag;
+  uint32_t period, hz;
+
+  if (!xvc_read_u32(&period)) return false;
+
+  jtag = gmm7550_jtag_acquire();
+  hz = jtag_set_clk_freq(jtag, period ? (1000000 + period - 1) / period : 0);
+  gmm7550_jtag_release();
+
+  return xvc_write_u32((1000000000 + hz - 1) / hz);
+}
+
+static bool xvc_cmd_getinfo(void)
+{
+  char info[32];
+
+  snprintf(info, sizeof(info), "xvcServer_v1.0:%u\n", XVC_MAX_BYTES);
+  return xvc_write((const uint8_t *)info, strlen(info));
+}
+
+/* Returns false if the host is gone or the command is not recognized */
+static bool xvc_command(void)
+{
+  char cmd[XVC_CMD_SIZE + 1];
+  uint i = 0;
+
+  do {
+    if (!xvc_read((uint8_t *)&cmd[i], 1)) return false;
+  } while (cmd[i++] != ':' && i < XVC_CMD_SIZE);
+  cmd[i] = '\0';
+
+  if (!strcmp(cmd, "shift:")) return xvc_cmd_shift();
+  if (!strcmp(cmd, "settck:")) return xvc_cmd_settck();
+  if (!strcmp(cmd, "getinfo:")) return xvc_cmd_getinfo();
+  return false;
+}
+
+static void xvc_task(__unused void *params)
+{
+  while(1) {
+    if (tud_cdc_n_connected(CDC_XVC) && tud_cdc_n_available(CDC_XVC)) {
+      if (!xvc_command()) {
+        /* out of sync, drop the rest of the input */
+        tud_cdc_n_read_flush(CDC_XVC);
+      }
+    } else {
+      vTaskDelay(1);
+    }
+  }
+}
+
+void gmm7550_xvc_init(void)
+{
+  xTaskCreate(xvc_task, "XVC",
+              configMINIMAL_STACK_SIZE,
+              NULL,
+              (tskIDLE_PRIORITY + 2UL),
+              NULL
+              );
+}
@@ -0,0 +1,146 @@
+#!/usr/bin/env python3
+#
+# This file is a part of the GMM-7550/RP2040 Control library
+# <https://github.com/gmm-7550/gmm7550-control-rp2040.git>
+#
+# SPDX-License-Identifier: MIT
+#
+# Copyright (c) 2026 Anton Kuzmin <ak@gmm7550.dev>
+
+'''Extract DirtyJTAG vendor endpoint traffic from a Linux usbmon capture
+(pcap or pcapng, e.g. recorded by Wireshark or tcpdump -i usbmonN while
+openFPGALoader talks to the probe) into the text capture format of
+djtag_replay (tools/djtag_replay):
+  > 0a 01 ...   OUT packet (host -> probe)
+  < 12 34 ...   IN packet (probe -> host)
+'''
+
+__version__ = '0.1.0'
+
+import sys
+import struct
+import argparse
+import logging
+
+DJTAG_EP_OUT = 0x01
+DJTAG_EP_IN = 0x82
+
+LINKTYPE_USB_LINUX = 189
+LINKTYPE_USB_LINUX_MMAPPED = 220
+
+USB_XFER_BULK = 3
+
+logging.basicConfig(stream=sys.stderr, level=logging.WARNING)
+log = logging.getLogger('djtag_capture')
+
+def pcap_records(f):
+    '''Yield (linktype, packet data) from pcap or pcapng file'''
+    hdr = f.read(24)
+    magic = struct.unpack('<I', hdr[:4])[0]
+    if magic in (0xa1b2c3d4, 0xa1b23c4d):
+        e = '<'
+    elif magic in (0xd4c3b2a1, 0x4d3cb2a1):
+        e = '>'
+    elif magic == 0x0a0d0d0a:
+        yield from pcapng_records(f, hdr)
+        return
+    else:
+        raise ValueError('not a pcap/pcapng file')
+    linktype = struct.unpack(e + 'I', hdr[20:24])[0]
+    while True:
+        rec = f.read(16)
+        if len(rec) < 16:
+            return
+        caplen = struct.unpack(e + 'I', rec[8:12])[0]
+        yield linktype, f.read(caplen)
+
+def pcapng_records(f, shb):
+    e = '<' if shb[8:12] == b'\x4d\x3c\x2b\x1a' else '>'
+    f.seek(struct.unpack(e + 'I', shb[4:8])[0])
+    linktypes = []
+    while True:
+        hdr = f.read(8)
+        if len(hdr) < 8:
+            return
+        btype, blen = struct.unpack(e + 'II', hdr)
+        body = f.read(blen - 8)
+        if btype == 0x00000001: # Interface Description Block
+            linktypes.append(struct.unpack(e + 'H', body[:2])[0])
+        elif btype == 0x00000006: # Enhanced Packet Block
+            ifc, _, _, caplen = struct.unpack(e + 'IIII', body[:16])
+            yield linktypes[ifc], body[20:20 + caplen]
+
+def usb_packets(fname, devnum):
+    '''Yield (endpoint, data) of bulk transfers with data'''
+    with open(fname, 'rb') as f:
+        for linktype, pkt in pcap_records(f):
+            if linktype == LINKTYPE_USB_LINUX:
+                hlen = 48
+            elif linktype == LINKTYPE_USB_LINUX_MMAPPED:
+                hlen = 64
+            else:
+                continue
+            # struct usbmon_packet, host byte order (little endian assumed)
+            (urb_type, xfer_type, epnum, dev, bus, flag_setup, flag_data,
+             ts_sec, ts_usec, status, length, len_cap) = struct.unpack('<xxxxxxxxcBBBHccqiiII', pkt[:40])
+            if xfer_type != USB_XFER_BULK or len_cap == 0:
+                continue
+            if devnum is not None and dev != devnum:
+                continue
+            data = pkt[hlen:hlen + len_cap]
+            # OUT data is seen on submission, IN data on completion
+            if urb_type == b'S' and epnum == DJTAG_EP_OUT:
+                yield dev, epnum, data
+            elif urb_type == b'C' and epnum == DJTAG_EP_IN:
+                yield dev, epnum, data
+
+def main():
+    p = argparse.ArgumentParser(description = __doc__,
+                                formatter_class=argparse.RawDescriptionHelpFormatter)
+
+    p.add_argument('-V', '--version', action='version', version=__version__)
+
+    p.add_argument('-v', '--verbose', action='count', default=0, help='be more verbose')
+
+    p.add_argument('-d', '--device', type=int,
+                   help='USB device address (default: the first one with DirtyJTAG traffic)')
+
+    p.add_argument('-o', '--output', type=str, default='-',
+                   help='output capture file (default: stdout)')
+
+    p.add_argument('file', help='usbmon capture (pcap or pcapng)')
+
+    args = p.parse_args()
+
+    if args.verbose == 0:
+        log.setLevel(logging.WARNING)
+    elif args.verbose == 1:
+        log.setLevel(logging.INFO)
+    else: # >= 2
+        log.setLevel(logging.DEBUG)
+
+    out = sys.stdout if args.output == '-' else open(args.output, 'w')
+    out.write('# DirtyJTAG packets from %s\n' % args.file)
+    devnum = args.device
+    n_out = n_in = 0
+    for dev, ep, data in usb_packets(args.file, devnum):
+        if devnum is None:
+            devnum = dev
+            log.info('USB device %d', dev)
+        elif dev != devnum:
+            continue
+        # 64-byte packets, as seen by the firmware
+        for i in range(0, len(data), 64):
+            chunk = data[i:i + 64]
+            out.write(('> ' if ep == DJTAG_EP_OUT else '< ') + ' '.join('%02x' % b for b in chunk) + '\n')
+        if ep == DJTAG_EP_OUT:
+            n_out += 1
+        else:
+            n_in += 1
+    log.info('%d OUT, %d IN transfers', n_out, n_in)
+    if out is not sys.stdout:
+        out.close()
+    return 0 if n_out else 1
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,20 @@
+/*
+ * Raspberry Pi RP2040 Control firmware for GMM-7550 module
+ * https://www.gmm7550.dev/doc/rp2040.html
+ *
+ * Copyright (c) 2026 Anton Kuzmin <ak@gmm7550.dev>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef _MOCK_FREERTOS_H
+#define _MOCK_FREERTOS_H
+
+#include "pico/stdlib.h"
+
+typedef uint32_t TickType_t;
+
+#define configTICK_RATE_HZ 1000
+#define portTICK_PERIOD_MS (1000 / configTICK_RATE_HZ)
+
+#endif
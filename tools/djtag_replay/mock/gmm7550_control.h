@@ -0,0 +1,16 @@
+/*
+ * Raspberry Pi RP2040 Control firmware for GMM-7550 module
+ * https://www.gmm7550.dev/doc/rp2040.html
+ *
+ * Copyright (c) 2026 Anton Kuzmin <ak@gmm7550.dev>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef _MOCK_GMM7550_CONTROL_H_
+#define _MOCK_GMM7550_CONTROL_H_
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#endif
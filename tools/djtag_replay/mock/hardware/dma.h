@@ -0,0 +1,66 @@
+/*
+ * Raspberry Pi RP2040 Control firmware for GMM-7550 module
+ * https://www.gmm7550.dev/doc/rp2040.html
+ *
+ * Copyright (c) 2026 Anton Kuzmin <ak@gmm7550.dev>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef _MOCK_HARDWARE_DMA_H
+#define _MOCK_HARDWARE_DMA_H
+
+#include "pico/stdlib.h"
+
+enum dma_channel_transfer_size {
+  DMA_SIZE_8 = 0,
+  DMA_SIZE_16 = 1,
+  DMA_SIZE_32 = 2
+};
+
+#define DREQ_PIO0_TX0 0
+#define DREQ_PIO0_RX0 4
+
+typedef struct {
+  enum dma_channel_transfer_size size;
+  bool read_increment;
+  bool write_increment;
+  bool bswap;
+  uint dreq;
+} dma_channel_config;
+
+static inline void channel_config_set_transfer_data_size(dma_channel_config *c, enum dma_channel_transfer_size size)
+{
+  c->size = size;
+}
+
+static inline void channel_config_set_read_increment(dma_channel_config *c, bool incr)
+{
+  c->read_increment = incr;
+}
+
+static inline void channel_config_set_write_increment(dma_channel_config *c, bool incr)
+{
+  c->write_increment = incr;
+}
+
+static inline void channel_config_set_bswap(dma_channel_config *c, bool bswap)
+{
+  c->bswap = bswap;
+}
+
+static inline void channel_config_set_dreq(dma_channel_config *c, uint dreq)
+{
+  c->dreq = dreq;
+}
+
+int dma_claim_unused_channel(bool required);
+dma_channel_config dma_channel_get_default_config(uint channel);
+void dma_channel_configure(uint channel, const dma_channel_config *config, volatile void *write_addr,
+                           const volatile void *read_addr, uint transfer_count, bool trigger);
+void dma_channel_set_config(uint channel, const dma_channel_config *config, bool trigger);
+void dma_channel_transfer_to_buffer_now(uint channel, volatile void *write_addr, uint32_t transfer_count);
+void dma_channel_transfer_from_buffer_now(uint channel, const volatile void *read_addr, uint32_t transfer_count);
+bool dma_channel_is_busy(uint channel);
+
+#endif
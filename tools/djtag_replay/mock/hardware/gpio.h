@@ -0,0 +1,36 @@
+/*
+ * Raspberry Pi RP2040 Control firmware for GMM-7550 module
+ * https://www.gmm7550.dev/doc/rp2040.html
+ *
+ * Copyright (c) 2026 Anton Kuzmin <ak@gmm7550.dev>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef _MOCK_HARDWARE_GPIO_H
+#define _MOCK_HARDWARE_GPIO_H
+
+#include "pico/stdlib.h"
+
+enum gpio_function {
+  GPIO_FUNC_SIO = 5,
+  GPIO_FUNC_PIO0 = 6,
+  GPIO_FUNC_NULL = 0x1f,
+};
+
+void gpio_init(uint gpio);
+void gpio_set_function(uint gpio, enum gpio_function fn);
+void gpio_set_dir(uint gpio, bool out);
+void gpio_set_dir_out_masked(uint32_t mask);
+void gpio_set_pulls(uint gpio, bool up, bool down);
+
+void gpio_put(uint gpio, bool value);
+void gpio_put_masked(uint32_t mask, uint32_t value);
+void gpio_set_mask(uint32_t mask);
+void gpio_clr_mask(uint32_t mask);
+
+bool gpio_get(uint gpio);
+uint32_t gpio_get_all(void);
+bool gpio_get_out_level(uint gpio);
+
+#endif
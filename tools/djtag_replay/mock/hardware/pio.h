@@ -0,0 +1,81 @@
+/*
+ * Raspberry Pi RP2040 Control firmware for GMM-7550 module
+ * https://www.gmm7550.dev/doc/rp2040.html
+ *
+ * Copyright (c) 2026 Anton Kuzmin <ak@gmm7550.dev>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* PIO registers are plain memory, except the FIFOs: the state machine
+ * running djtag_tdo program is modelled behind pio_sm_put()/pio_sm_get()
+ * and the FIFO status functions (see sim.c)
+ */
+
+#ifndef _MOCK_HARDWARE_PIO_H
+#define _MOCK_HARDWARE_PIO_H
+
+#include "pico/stdlib.h"
+#include "hardware/gpio.h"
+
+typedef volatile uint32_t io_rw_32;
+typedef volatile uint32_t io_ro_32;
+typedef volatile uint32_t io_wo_32;
+typedef volatile uint8_t io_rw_8;
+
+typedef struct {
+  io_rw_32 clkdiv;
+  io_rw_32 execctrl;
+  io_rw_32 shiftctrl;
+  io_ro_32 addr;
+  io_rw_32 instr;
+  io_rw_32 pinctrl;
+} pio_sm_hw_t;
+
+typedef struct {
+  io_rw_32 ctrl;
+  io_ro_32 fstat;
+  io_rw_32 fdebug;
+  io_ro_32 flevel;
+  io_wo_32 txf[4];
+  io_ro_32 rxf[4];
+  io_rw_32 input_sync_bypass;
+  pio_sm_hw_t sm[4];
+} pio_hw_t;
+
+typedef pio_hw_t *PIO;
+
+extern pio_hw_t sim_pio0_hw;
+#define pio0_hw (&sim_pio0_hw)
+#define pio0 pio0_hw
+
+#define PIO_SM0_SHIFTCTRL_PULL_THRESH_LSB  25
+#define PIO_SM0_SHIFTCTRL_PULL_THRESH_BITS 0x3e000000
+#define PIO_SM0_SHIFTCTRL_PUSH_THRESH_LSB  20
+#define PIO_SM0_SHIFTCTRL_PUSH_THRESH_BITS 0x01f00000
+#define PIO_FDEBUG_TXSTALL_LSB 24
+
+static inline void hw_write_masked(io_rw_32 *addr, uint32_t values, uint32_t write_mask)
+{
+  *addr = (*addr & ~write_mask) | (values & write_mask);
+}
+
+enum pio_src_dest { pio_pins = 0 };
+
+static inline uint pio_encode_set(enum pio_src_dest dest, uint value)
+{
+  return 0xe000 | (dest << 5) | (value & 0x1f);
+}
+
+void pio_sm_put(PIO pio, uint sm, uint32_t data);
+uint32_t pio_sm_get(PIO pio, uint sm);
+bool pio_sm_is_tx_fifo_full(PIO pio, uint sm);
+bool pio_sm_is_tx_fifo_empty(PIO pio, uint sm);
+bool pio_sm_is_rx_fifo_empty(PIO pio, uint sm);
+
+void pio_sm_exec(PIO pio, uint sm, uint instr);
+void pio_sm_set_pins_with_mask(PIO pio, uint sm, uint32_t pin_values, uint32_t pin_mask);
+void pio_sm_set_clkdiv_int_frac(PIO pio, uint sm, uint16_t div_int, uint8_t div_frac);
+void pio_gpio_init(PIO pio, uint pin);
+
+#endif
@@ -0,0 +1,19 @@
+/*
+ * Raspberry Pi RP2040 Control firmware for GMM-7550 module
+ * https://www.gmm7550.dev/doc/rp2040.html
+ *
+ * Copyright (c) 2026 Anton Kuzmin <ak@gmm7550.dev>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* Generated by pioasm in the firmware build, the program is modelled by sim.c */
+
+#ifndef _MOCK_JTAG_PIO_H
+#define _MOCK_JTAG_PIO_H
+
+#include "hardware/pio.h"
+
+void pio_jtag_init(PIO pio, uint sm, uint16_t clkdiv, uint pin_tck, uint pin_tdi, uint pin_tdo, uint pin_tms);
+
+#endif
@@ -0,0 +1,37 @@
+/*
+ * Raspberry Pi RP2040 Control firmware for GMM-7550 module
+ * https://www.gmm7550.dev/doc/rp2040.html
+ *
+ * Copyright (c) 2026 Anton Kuzmin <ak@gmm7550.dev>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* Host build of the DirtyJTAG engine: the subset of pico-sdk used by djtag/ */
+
+#ifndef _MOCK_PICO_STDLIB_H
+#define _MOCK_PICO_STDLIB_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef unsigned int uint;
+
+#define MIN(a, b) ((b) < (a) ? (b) : (a))
+#define MAX(a, b) ((a) < (b) ? (b) : (a))
+
+#define __time_critical_func(f) f
+#define __aligned(x) __attribute__((aligned(x)))
+#define __unused __attribute__((unused))
+
+#define __compiler_memory_barrier() __asm__ volatile ("" : : : "memory")
+
+/* CPU time is modelled, see sim.c */
+void tight_loop_contents(void);
+void busy_wait_at_least_cycles(uint32_t cycles);
+uint32_t time_us_32(void);
+
+#include "hardware/gpio.h"
+
+#endif
@@ -0,0 +1,18 @@
+/*
+ * Raspberry Pi RP2040 Control firmware for GMM-7550 module
+ * https://www.gmm7550.dev/doc/rp2040.html
+ *
+ * Copyright (c) 2026 Anton Kuzmin <ak@gmm7550.dev>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef _MOCK_TASK_H
+#define _MOCK_TASK_H
+
+#include "FreeRTOS.h"
+
+/* The calling task sleeps until the next tick(s), see sim.c */
+void vTaskDelay(const TickType_t ticks);
+
+#endif
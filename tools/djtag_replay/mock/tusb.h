@@ -0,0 +1,17 @@
+/*
+ * Raspberry Pi RP2040 Control firmware for GMM-7550 module
+ * https://www.gmm7550.dev/doc/rp2040.html
+ *
+ * Copyright (c) 2026 Anton Kuzmin <ak@gmm7550.dev>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* USB side is replaced by the capture replay (replay.c) */
+
+#ifndef _MOCK_TUSB_H
+#define _MOCK_TUSB_H
+
+#include "pico/stdlib.h"
+
+#endif
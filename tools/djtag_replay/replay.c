@@ -0,0 +1,348 @@
+/*
+ * Raspberry Pi RP2040 Control firmware for GMM-7550 module
+ * https://www.gmm7550.dev/doc/rp2040.html
+ *
+ * Copyright (c) 2026 Anton Kuzmin <ak@gmm7550.dev>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* DirtyJTAG command stream replay
+ *
+ * Recorded vendor endpoint traffic is fed through cmd_handle(), built
+ * for the host against the RP2040 model (sim.c), and the responses are
+ * compared to the recorded ones.  Capture is a text file, one packet
+ * per line (tools/djtag_capture.py makes it from a usbmon capture):
+ *   > 0a 01 ...   OUT packet (host -> probe), up to 64 bytes
+ *   < 12 34 ...   IN packet (probe -> host)
+ *   # comment
+ * The time is simulated: TCK and PIO FIFO timing, CPU register access
+ * cost and the FreeRTOS ticks spent in vTaskDelay(); USB transfers are
+ * not included.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+
+#include "pico/stdlib.h"
+#include "pio_jtag.h"
+#include "trace.h"
+#include "cmd.h"
+#include "sim.h"
+
+#define PACKET_SIZE 64
+
+/* firmware pins, the model does not care */
+#define PIN_TDI  16
+#define PIN_TCK  17
+#define PIN_TDO  18
+#define PIN_TMS  19
+#define PIN_RST  20
+#define PIN_TRST 21
+
+#define N_OPCODES 17 /* command & 0x0f, and CMD_XFER_LONG data */
+
+static const char *opcode_names[N_OPCODES] = {
+  "STOP", "INFO", "FREQ", "XFER", "SETSIG", "GETSIG", "CLK", "SETVOLTAGE",
+  "GOTOBOOTLOADER", "XFER_LONG", "TAP_GOTO", "TAP_SHIFT", "TAP_RUN", "EDGES",
+  "CMD_0e", "CMD_0f", "XFER_LONG data"
+};
+
+typedef struct packet {
+  bool out;
+  uint32_t line;
+  uint32_t len;
+  uint8_t data[PACKET_SIZE];
+} packet_t;
+
+typedef struct buffer {
+  uint8_t *data;
+  size_t len;
+  size_t size;
+} buffer_t;
+
+static pio_jtag_inst_t jtag = {
+  .pio = pio0,
+  .sm = 0,
+};
+
+static struct {
+  uint64_t count;
+  uint64_t bits;
+  uint64_t us;
+} op_stat[N_OPCODES];
+
+static int verbose;
+
+static void buffer_append(buffer_t *b, const uint8_t *data, size_t len)
+{
+  if (b->len + len > b->size) {
+    b->size = (b->len + len) * 2;
+    b->data = realloc(b->data, b->size);
+    if (!b->data) {
+      perror("djtag_replay");
+      exit(2);
+    }
+  }
+  memcpy(b->data + b->len, data, len);
+  b->len += len;
+}
+
+/* Returns number of packets, or -1 on error */
+static long read_capture(const char *fname, packet_t **packets)
+{
+  FILE *f = strcmp(fname, "-") ? fopen(fname, "r") : stdin;
+  char line[4 * PACKET_SIZE + 16];
+  uint32_t lineno = 0;
+  long n = 0, size = 0;
+  char *p, *end;
+  packet_t *pkt;
+
+  if (!f) {
+    perror(fname);
+    return -1;
+  }
+  *packets = NULL;
+  while (fgets(line, sizeof(line), f)) {
+    lineno++;
+    p = line;
+    while (isspace((unsigned char)*p)) p++;
+    if (*p == '\0' || *p == '#') continue;
+    if (*p != '>' && *p != '<') {
+      fprintf(stderr, "%s:%u: packet direction ('>' or '<') expected\n", fname, lineno);
+      return -1;
+    }
+    if (n == size) {
+      size = size ? 2 * size : 1024;
+      *packets = realloc(*packets, size * sizeof(packet_t));
+      if (!*packets) {
+        perror("djtag_replay");
+        return -1;
+      }
+    }
+    pkt = &(*packets)[n];
+    pkt->out = (*p++ == '>');
+    pkt->line = lineno;
+    pkt->len = 0;
+    for (;;) {
+      unsigned long b = strtoul(p, &end, 16);
+      if (end == p) break;
+      if (b > 0xff || pkt->len == PACKET_SIZE) {
+        fprintf(stderr, "%s:%u: bad packet data\n", fname, lineno);
+        return -1;
+      }
+      pkt->data[pkt->len++] = b;
+      p = end;
+    }
+    while (isspace((unsigned char)*p)) p++;
+    if (*p != '\0') {
+      fprintf(stderr, "%s:%u: bad packet data\n", fname, lineno);
+      return -1;
+    }
+    if (pkt->len) n++; /* zero length packets carry no data */
+  }
+  if (f != stdin) fclose(f);
+  return n;
+}
+
+static void write_packet(FILE *f, char dir, const uint8_t *data, size_t len)
+{
+  fputc(dir, f);
+  for (size_t i = 0; i < len; i++) {
+    fprintf(f, " %02x", data[i]);
+  }
+  fputc('\n', f);
+}
+
+/* Collect the trace of the last packet into per command statistics */
+static void collect_trace(void)
+{
+  for (uint32_t i = 0; i < trace_count(); i++) {
+    const djtag_trace_t *t = trace_get(i);
+    const uint op = (t->opcode == TRACE_OP_DATA) ? N_OPCODES - 1 : (t->opcode & 0x0f);
+
+    op_stat[op].count++;
+    op_stat[op].bits += t->bits;
+    op_stat[op].us += t->t_done - t->t_start;
+  }
+  trace_clear();
+}
+
+static double rate(uint64_t n, double seconds)
+{
+  return seconds > 0 ? n / seconds : 0;
+}
+
+static void usage(FILE *f)
+{
+  fprintf(f,
+          "Usage: djtag_replay [options] capture\n"
+          "Replay DirtyJTAG vendor endpoint capture through the firmware command handler\n\n"
+          "  -f khz     initial TCK frequency (default: 1000)\n"
+          "  -s mhz     clk_sys frequency (default: 125)\n"
+          "  -c cycles  CPU cycles per PIO/DMA register access (default: 4)\n"
+          "  -i idcode  target IDCODE, hex (default: 20000a53, 0 -- no IDCODE)\n"
+          "  -l irlen   target IR length (default: 6)\n"
+          "  -I ir      instruction selecting IDCODE, hex (default: only after reset)\n"
+          "  -n         do not compare the responses to the captured ones\n"
+          "  -w file    write the capture with the replayed responses\n"
+          "  -v         print per command statistics\n"
+          "  -h         this help\n");
+}
+
+int main(int argc, char *argv[])
+{
+  sim_params_t par = {
+    .clk_sys_hz = 125000000,
+    .access_cycles = 4,
+    .idcode = 0x20000a53,
+    .ir_len = 6,
+    .idcode_ir = -1,
+  };
+  uint freq_khz = 1000;
+  bool check = true;
+  const char *out_fname = NULL;
+  FILE *out = NULL;
+  packet_t *packets;
+  long n_packets;
+  buffer_t reply = {0}, golden = {0};
+  uint32_t *reply_line; /* capture line of the OUT packet for every response byte */
+  uint32_t n_out = 0, n_in = 0;
+  uint64_t out_bytes = 0, commands = 0, bits = 0;
+  uint64_t t_start;
+  double seconds;
+  const sim_stat_t *st;
+  int opt, ret = 0;
+
+  static uint8_t rx_buf[PACKET_SIZE + 4] __aligned(4);
+  static uint8_t tx_buf[PACKET_SIZE * CMD_MAX_REPLY] __aligned(4);
+
+  while ((opt = getopt(argc, argv, "f:s:c:i:l:I:nw:vh")) != -1) {
+    switch (opt) {
+    case 'f': freq_khz = strtoul(optarg, NULL, 0); break;
+    case 's': par.clk_sys_hz = strtoul(optarg, NULL, 0) * 1000000; break;
+    case 'c': par.access_cycles = strtoul(optarg, NULL, 0); break;
+    case 'i': par.idcode = strtoul(optarg, NULL, 16); break;
+    case 'l': par.ir_len = strtoul(optarg, NULL, 0); break;
+    case 'I': par.idcode_ir = strtol(optarg, NULL, 16); break;
+    case 'n': check = false; break;
+    case 'w': out_fname = optarg; break;
+    case 'v': verbose++; break;
+    case 'h': usage(stdout); return 0;
+    default: usage(stderr); return 2;
+    }
+  }
+  if (optind != argc - 1 || par.clk_sys_hz == 0) {
+    usage(stderr);
+    return 2;
+  }
+
+  n_packets = read_capture(argv[optind], &packets);
+  if (n_packets < 0) return 2;
+
+  if (out_fname) {
+    out = fopen(out_fname, "w");
+    if (!out) {
+      perror(out_fname);
+      return 2;
+    }
+    fprintf(out, "# %s replayed by djtag_replay\n", argv[optind]);
+  }
+
+  reply_line = malloc((n_packets + 1) * PACKET_SIZE * CMD_MAX_REPLY * sizeof(uint32_t));
+  if (!reply_line) {
+    perror("djtag_replay");
+    return 2;
+  }
+
+  sim_init(&par);
+  init_jtag(&jtag, freq_khz, PIN_TCK, PIN_TDI, PIN_TDO, PIN_TMS, PIN_RST, PIN_TRST);
+  trace_clear();
+
+  t_start = sim_now();
+  for (long i = 0; i < n_packets; i++) {
+    const packet_t *pkt = &packets[i];
+    uint32_t n;
+
+    if (!pkt->out) {
+      n_in++;
+      buffer_append(&golden, pkt->data, pkt->len);
+      continue;
+    }
+    n_out++;
+    out_bytes += pkt->len;
+    memcpy(rx_buf, pkt->data, pkt->len);
+    n = cmd_handle(&jtag, rx_buf, pkt->len, tx_buf);
+    for (uint32_t j = 0; j < n; j++) {
+      reply_line[reply.len + j] = pkt->line;
+    }
+    buffer_append(&reply, tx_buf, n);
+    collect_trace();
+
+    if (out) {
+      write_packet(out, '>', pkt->data, pkt->len);
+      for (uint32_t j = 0; j < n; j += PACKET_SIZE) {
+        write_packet(out, '<', tx_buf + j, MIN(n - j, PACKET_SIZE));
+      }
+    }
+  }
+  seconds = (double)(sim_now() - t_start) / par.clk_sys_hz;
+  st = sim_stat();
+
+  for (uint op = 0; op < N_OPCODES; op++) {
+    if (op != N_OPCODES - 1) commands += op_stat[op].count;
+    bits += op_stat[op].bits;
+  }
+
+  printf("%s: %u OUT packets (%llu bytes), %u IN packets (%zu bytes)\n",
+         argv[optind], n_out, (unsigned long long)out_bytes, n_in, golden.len);
+  printf("simulated time %.3f ms, clk_sys %u MHz, %u cycles per register access\n",
+         seconds * 1000, par.clk_sys_hz / 1000000, par.access_cycles);
+  printf("  commands   %10llu  %12.0f commands/s\n", (unsigned long long)commands, rate(commands, seconds));
+  printf("  bits       %10llu  %12.0f bits/s\n", (unsigned long long)bits, rate(bits, seconds));
+  printf("  TCK pulses %10llu  PIO %llu, SIO %llu, TCK busy %.1f%%\n",
+         (unsigned long long)(st->tck_bits + st->sio_edges),
+         (unsigned long long)st->tck_bits, (unsigned long long)st->sio_edges,
+         seconds > 0 ? 100.0 * st->tck_cycles / par.clk_sys_hz / seconds : 0);
+  printf("  responses  %10zu  bytes\n", reply.len);
+  printf("  vTaskDelay %10llu  calls, PIO stalls %llu\n",
+         (unsigned long long)st->task_delays, (unsigned long long)st->pio_stalls);
+
+  if (verbose) {
+    printf("\n  %-16s %10s %12s %12s\n", "command", "count", "bits", "time, us");
+    for (uint op = 0; op < N_OPCODES; op++) {
+      if (!op_stat[op].count) continue;
+      printf("  %-16s %10llu %12llu %12llu\n", opcode_names[op],
+             (unsigned long long)op_stat[op].count, (unsigned long long)op_stat[op].bits,
+             (unsigned long long)op_stat[op].us);
+    }
+    printf("\n");
+  }
+
+  if (check) {
+    size_t n = MIN(reply.len, golden.len), diff = 0, first = n;
+
+    for (size_t i = 0; i < n; i++) {
+      if (reply.data[i] != golden.data[i]) {
+        if (first == n) first = i;
+        diff++;
+      }
+    }
+    if (first < n) {
+      printf("golden TDO: MISMATCH at byte %zu (OUT packet at line %u): 0x%02x, expected 0x%02x; %zu bytes differ\n",
+             first, reply_line[first], reply.data[first], golden.data[first], diff);
+      ret = 1;
+    } else if (reply.len != golden.len) {
+      printf("golden TDO: %zu response bytes, %zu expected\n", reply.len, golden.len);
+      ret = 1;
+    } else {
+      printf("golden TDO: match (%zu bytes)\n", n);
+    }
+  }
+
+  if (out) fclose(out);
+  return ret;
+}
@@ -0,0 +1,695 @@
+/*
+ * Raspberry Pi RP2040 Control firmware for GMM-7550 module
+ * https://www.gmm7550.dev/doc/rp2040.html
+ *
+ * Copyright (c) 2026 Anton Kuzmin <ak@gmm7550.dev>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* RP2040 model for the host build of the DirtyJTAG engine, see sim.h */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+#include "hardware/dma.h"
+#include "hardware/clocks.h"
+#include "task.h"
+#include "jtag.pio.h"
+#include "sim.h"
+
+/* djtag_tdo program: instructions from the header pull to the first
+ * bit, extra instructions for the last bit (TMS), and the final push
+ */
+#define SM_HEADER_CYCLES   9
+#define SM_BIT_CYCLES      4
+#define SM_LAST_BIT_CYCLES 3
+#define SM_PUSH_CYCLES     1
+
+#define FIFO_DEPTH 4
+#define DMA_CHANNELS 12
+#define N_GPIO 30
+
+/* Nothing has moved for that long -- the firmware waits for the model forever */
+#define STUCK_SECONDS 10
+
+pio_hw_t sim_pio0_hw;
+
+static sim_params_t par;
+static sim_stat_t stat;
+static uint64_t cpu_t;
+static uint64_t progress_t;
+
+static void sim_fatal(const char *msg)
+{
+  fprintf(stderr, "djtag_replay: model: %s (at %llu cycles)\n", msg, (unsigned long long)cpu_t);
+  exit(2);
+}
+
+/* ---- JTAG target ---- */
+
+enum {
+  TAP_TLR, TAP_RTI,
+  TAP_SEL_DR, TAP_CAP_DR, TAP_SH_DR, TAP_EX1_DR, TAP_PAU_DR, TAP_EX2_DR, TAP_UPD_DR,
+  TAP_SEL_IR, TAP_CAP_IR, TAP_SH_IR, TAP_EX1_IR, TAP_PAU_IR, TAP_EX2_IR, TAP_UPD_IR
+};
+
+/* next state for TMS 0 and 1 */
+static const uint8_t tap_next[16][2] = {
+  [TAP_TLR]    = {TAP_RTI,    TAP_TLR},
+  [TAP_RTI]    = {TAP_RTI,    TAP_SEL_DR},
+  [TAP_SEL_DR] = {TAP_CAP_DR, TAP_SEL_IR},
+  [TAP_CAP_DR] = {TAP_SH_DR,  TAP_EX1_DR},
+  [TAP_SH_DR]  = {TAP_SH_DR,  TAP_EX1_DR},
+  [TAP_EX1_DR] = {TAP_PAU_DR, TAP_UPD_DR},
+  [TAP_PAU_DR] = {TAP_PAU_DR, TAP_EX2_DR},
+  [TAP_EX2_DR] = {TAP_SH_DR,  TAP_UPD_DR},
+  [TAP_UPD_DR] = {TAP_RTI,    TAP_SEL_DR},
+  [TAP_SEL_IR] = {TAP_CAP_IR, TAP_TLR},
+  [TAP_CAP_IR] = {TAP_SH_IR,  TAP_EX1_IR},
+  [TAP_SH_IR]  = {TAP_SH_IR,  TAP_EX1_IR},
+  [TAP_EX1_IR] = {TAP_PAU_IR, TAP_UPD_IR},
+  [TAP_PAU_IR] = {TAP_PAU_IR, TAP_EX2_IR},
+  [TAP_EX2_IR] = {TAP_SH_IR,  TAP_UPD_IR},
+  [TAP_UPD_IR] = {TAP_RTI,    TAP_SEL_DR},
+};
+
+static struct {
+  int state;
+  uint32_t ir_sr;
+  uint32_t dr_sr;
+  uint32_t dr_len;
+  bool idcode_sel;
+  bool tdo;
+} tap;
+
+static uint32_t tap_ir_mask(void)
+{
+  return (par.ir_len >= 32) ? 0xffffffff : (1u << par.ir_len) - 1;
+}
+
+/* TDI and TMS are sampled on the rising TCK edge */
+static void tap_rise(bool tms, bool tdi)
+{
+  switch (tap.state) {
+  case TAP_TLR:
+    tap.idcode_sel = (par.idcode != 0);
+    break;
+  case TAP_CAP_IR:
+    tap.ir_sr = 1;
+    break;
+  case TAP_SH_IR:
+    tap.ir_sr = (tap.ir_sr >> 1) | ((uint32_t)tdi << (par.ir_len - 1));
+    break;
+  case TAP_CAP_DR:
+    tap.dr_sr = tap.idcode_sel ? par.idcode : 0;
+    tap.dr_len = tap.idcode_sel ? 32 : 1;
+    break;
+  case TAP_SH_DR:
+    tap.dr_sr = (tap.dr_sr >> 1) | ((uint32_t)tdi << (tap.dr_len - 1));
+    break;
+  }
+  tap.state = tap_next[tap.state][tms];
+}
+
+/* TDO and the instruction are updated on the falling edge */
+static void tap_fall(void)
+{
+  uint32_t ir;
+
+  switch (tap.state) {
+  case TAP_SH_IR:
+    tap.tdo = tap.ir_sr & 1;
+    break;
+  case TAP_SH_DR:
+    tap.tdo = tap.dr_sr & 1;
+    break;
+  case TAP_UPD_IR:
+    ir = tap.ir_sr & tap_ir_mask();
+    tap.idcode_sel = par.idcode && par.idcode_ir >= 0 && ir == (uint32_t)par.idcode_ir;
+    tap.tdo = false;
+    break;
+  default:
+    tap.tdo = false; /* not driven, TDO is pulled down */
+    break;
+  }
+}
+
+/* ---- pins ---- */
+
+static uint8_t pin_func[N_GPIO];
+static uint32_t sio_out;
+static uint32_t pio_out;
+static struct {
+  bool valid;
+  uint tck, tdi, tdo, tms;
+} pins;
+static bool tck_level;
+
+static bool pin_level(uint pin)
+{
+  if (pins.valid && pin == pins.tdo) return tap.tdo;
+  switch (pin_func[pin]) {
+  case GPIO_FUNC_SIO:
+    return (sio_out >> pin) & 1;
+  case GPIO_FUNC_PIO0:
+    return (pio_out >> pin) & 1;
+  default:
+    return false;
+  }
+}
+
+static void pins_update(void)
+{
+  bool tck;
+
+  if (!pins.valid) return;
+  tck = pin_level(pins.tck);
+  if (tck == tck_level) return;
+  tck_level = tck;
+  if (tck) {
+    tap_rise(pin_level(pins.tms), pin_level(pins.tdi));
+    if (pin_func[pins.tck] == GPIO_FUNC_SIO) stat.sio_edges++;
+  } else {
+    tap_fall();
+  }
+}
+
+static void pio_pin_put(uint pin, bool value)
+{
+  pio_out = (pio_out & ~(1u << pin)) | ((uint32_t)value << pin);
+  pins_update();
+}
+
+/* ---- FIFOs ---- */
+
+typedef struct {
+  uint32_t v[FIFO_DEPTH];
+  uint64_t t[FIFO_DEPTH]; /* when the word has been written */
+  uint head;
+  uint count;
+} fifo_t;
+
+static fifo_t txf, rxf;
+static uint64_t rx_free_t; /* last RX FIFO read */
+
+static void fifo_push(fifo_t *f, uint32_t v, uint64_t t)
+{
+  uint i = (f->head + f->count) % FIFO_DEPTH;
+
+  f->v[i] = v;
+  f->t[i] = t;
+  f->count++;
+}
+
+static uint32_t fifo_pop(fifo_t *f, uint64_t *t)
+{
+  uint32_t v = f->v[f->head];
+
+  if (t) *t = f->t[f->head];
+  f->head = (f->head + 1) % FIFO_DEPTH;
+  f->count--;
+  return v;
+}
+
+/* ---- state machine ---- */
+
+enum { SM_HEADER, SM_BIT, SM_PUSH, SM_END };
+
+static struct {
+  int phase;
+  uint64_t t; /* PIO time line */
+  uint32_t osr;
+  uint osr_count; /* bits left in OSR */
+  uint32_t isr;
+  uint isr_count;
+  uint32_t bits_left;
+  bool tms;
+  bool tms_last;
+} sm;
+
+static uint sm_threshold(uint32_t bits, uint lsb)
+{
+  uint th = (sim_pio0_hw.sm[0].shiftctrl & bits) >> lsb;
+  return th ? th : 32;
+}
+
+static uint64_t sm_cycles(uint n)
+{
+  /* 16.8 fixed point divider */
+  return ((uint64_t)n * (sim_pio0_hw.sm[0].clkdiv >> 8) + 255) >> 8;
+}
+
+/* Returns false if the state machine is stalled, or is ahead of until */
+static bool sm_step(uint64_t until)
+{
+  uint64_t t;
+  uint32_t w;
+  bool last, tdi;
+
+  if (sm.t > until) return false;
+
+  switch (sm.phase) {
+  case SM_HEADER:
+    if (txf.count == 0) return false;
+    w = fifo_pop(&txf, &t);
+    sm.t = MAX(sm.t, t) + sm_cycles(SM_HEADER_CYCLES);
+    sm.tms = w >> 31;
+    sm.tms_last = (w >> 30) & 1;
+    sm.bits_left = (w & 0x3fffffff) + 1;
+    sm.osr_count = 0; /* pull disregards the previous OSR state */
+    sm.isr = sm.isr_count = 0;
+    pio_pin_put(pins.tms, sm.tms);
+    sm.phase = SM_BIT;
+    break;
+
+  case SM_BIT:
+    if (sm.osr_count == 0) {
+      if (txf.count == 0) return false;
+      w = fifo_pop(&txf, &t);
+      if (t > sm.t) {
+        stat.pio_stalls++;
+        sm.t = t;
+      }
+      sm.osr = w;
+      sm.osr_count = sm_threshold(PIO_SM0_SHIFTCTRL_PULL_THRESH_BITS, PIO_SM0_SHIFTCTRL_PULL_THRESH_LSB);
+    }
+    last = (sm.bits_left == 1);
+    if (last) pio_pin_put(pins.tms, sm.tms_last);
+    tdi = sm.osr >> 31;
+    sm.osr <<= 1;
+    sm.osr_count--;
+    pio_pin_put(pins.tdi, tdi);
+    pio_pin_put(pins.tck, true);
+    sm.isr = (sm.isr << 1) | tap.tdo;
+    sm.isr_count++;
+    pio_pin_put(pins.tck, false);
+    sm.t += sm_cycles(SM_BIT_CYCLES + (last ? SM_LAST_BIT_CYCLES : 0));
+    stat.tck_cycles += sm_cycles(SM_BIT_CYCLES);
+    stat.tck_bits++;
+    sm.bits_left--;
+    if (sm.isr_count == sm_threshold(PIO_SM0_SHIFTCTRL_PUSH_THRESH_BITS, PIO_SM0_SHIFTCTRL_PUSH_THRESH_LSB))
+      sm.phase = SM_PUSH;
+    else if (sm.bits_left == 0)
+      sm.phase = SM_END;
+    break;
+
+  case SM_PUSH: /* autopush */
+  case SM_END:  /* push at the end of the transfer */
+    if (rxf.count == FIFO_DEPTH) return false;
+    if (rx_free_t > sm.t) {
+      stat.pio_stalls++;
+      sm.t = rx_free_t;
+    }
+    fifo_push(&rxf, sm.isr, sm.t);
+    sm.isr = sm.isr_count = 0;
+    if (sm.phase == SM_END) {
+      sm.t += sm_cycles(SM_PUSH_CYCLES);
+      sm.phase = SM_HEADER;
+    } else {
+      sm.phase = sm.bits_left ? SM_BIT : SM_END;
+    }
+    break;
+  }
+  progress_t = cpu_t;
+  return true;
+}
+
+/* ---- DMA ---- */
+
+static struct {
+  dma_channel_config c;
+  bool claimed;
+  volatile uint8_t *write_addr;
+  const volatile uint8_t *read_addr;
+  uint32_t count;
+  uint64_t t;      /* started */
+  uint64_t done_t; /* last transfer */
+} dma[DMA_CHANNELS];
+
+static uint dma_size(const dma_channel_config *c)
+{
+  if (c->size == DMA_SIZE_16) sim_fatal("16-bit DMA transfers are not modelled");
+  return (c->size == DMA_SIZE_32) ? 4 : 1;
+}
+
+static void dma_service(void)
+{
+  uint32_t v;
+  uint64_t t;
+
+  for (uint ch = 0; ch < DMA_CHANNELS; ch++) {
+    const uint size = dma_size(&dma[ch].c);
+
+    if (!dma[ch].count) continue;
+
+    if (dma[ch].c.dreq == DREQ_PIO0_TX0) {
+      while (dma[ch].count && txf.count < FIFO_DEPTH) {
+        if (size == 1) {
+          /* narrow writes are replicated to all byte lanes */
+          v = *dma[ch].read_addr * 0x01010101u;
+        } else {
+          memcpy(&v, (const void *)dma[ch].read_addr, 4);
+          if (dma[ch].c.bswap) v = __builtin_bswap32(v);
+        }
+        if (dma[ch].c.read_increment) dma[ch].read_addr += size;
+        t = MAX(dma[ch].t, sm.t);
+        fifo_push(&txf, v, t);
+        dma[ch].done_t = t;
+        dma[ch].count--;
+        progress_t = cpu_t;
+      }
+    } else if (dma[ch].c.dreq == DREQ_PIO0_RX0) {
+      while (dma[ch].count && rxf.count) {
+        v = fifo_pop(&rxf, &t);
+        if (size == 1) {
+          *dma[ch].write_addr = v;
+        } else {
+          if (dma[ch].c.bswap) v = __builtin_bswap32(v);
+          memcpy((void *)dma[ch].write_addr, &v, 4);
+        }
+        if (dma[ch].c.write_increment) dma[ch].write_addr += size;
+        t = MAX(dma[ch].t, t);
+        dma[ch].done_t = t;
+        rx_free_t = MAX(rx_free_t, t);
+        dma[ch].count--;
+        progress_t = cpu_t;
+      }
+    } else {
+      sim_fatal("only PIO paced DMA transfers are modelled");
+    }
+  }
+}
+
+/* ---- CPU time line ---- */
+
+static void sim_run(uint64_t until)
+{
+  do {
+    dma_service();
+  } while (sm_step(until));
+
+  /* TXSTALL is set while the state machine waits for the header */
+  if (sm.phase == SM_HEADER && txf.count == 0 && sm.t <= until)
+    sim_pio0_hw.fdebug |= 1u << PIO_FDEBUG_TXSTALL_LSB;
+  else
+    sim_pio0_hw.fdebug &= ~(1u << PIO_FDEBUG_TXSTALL_LSB);
+}
+
+static void cpu_access(void)
+{
+  cpu_t += par.access_cycles;
+  sim_run(cpu_t);
+  if (cpu_t - progress_t > (uint64_t)STUCK_SECONDS * par.clk_sys_hz)
+    sim_fatal("firmware waits for PIO/DMA forever");
+}
+
+/* SIO registers are single cycle */
+static void sio_access(void)
+{
+  cpu_t++;
+  progress_t = cpu_t;
+}
+
+void sim_init(const sim_params_t *params)
+{
+  par = *params;
+  if (par.ir_len < 2 || par.ir_len > 32) sim_fatal("IR length should be 2..32");
+  memset(&stat, 0, sizeof(stat));
+  cpu_t = progress_t = 0;
+  tap.state = TAP_TLR;
+  tap.idcode_sel = (par.idcode != 0);
+  tap.tdo = false;
+}
+
+uint64_t sim_now(void)
+{
+  return cpu_t;
+}
+
+const sim_stat_t *sim_stat(void)
+{
+  return &stat;
+}
+
+/* ---- pico-sdk ---- */
+
+void tight_loop_contents(void)
+{
+  cpu_access();
+}
+
+void busy_wait_at_least_cycles(uint32_t cycles)
+{
+  cpu_t += cycles;
+  sim_run(cpu_t);
+}
+
+uint32_t time_us_32(void)
+{
+  return (uint32_t)(cpu_t * 1000000 / par.clk_sys_hz);
+}
+
+uint32_t clock_get_hz(enum clock_index clk)
+{
+  return par.clk_sys_hz;
+}
+
+void vTaskDelay(const TickType_t ticks)
+{
+  const uint64_t tick = par.clk_sys_hz / configTICK_RATE_HZ;
+
+  stat.task_delays++;
+  cpu_t = (cpu_t / tick + ticks) * tick;
+  sim_run(cpu_t);
+  progress_t = cpu_t;
+}
+
+void gpio_init(uint gpio)
+{
+  sio_access();
+  sio_out &= ~(1u << gpio);
+  pin_func[gpio] = GPIO_FUNC_SIO;
+  pins_update();
+}
+
+void gpio_set_function(uint gpio, enum gpio_function fn)
+{
+  sio_access();
+  pin_func[gpio] = fn;
+  pins_update();
+}
+
+void gpio_set_dir(uint gpio, bool out)
+{
+  sio_access();
+}
+
+void gpio_set_dir_out_masked(uint32_t mask)
+{
+  sio_access();
+}
+
+void gpio_set_pulls(uint gpio, bool up, bool down)
+{
+}
+
+void gpio_put(uint gpio, bool value)
+{
+  sio_access();
+  sio_out = (sio_out & ~(1u << gpio)) | ((uint32_t)value << gpio);
+  pins_update();
+}
+
+void gpio_put_masked(uint32_t mask, uint32_t value)
+{
+  sio_access();
+  sio_out = (sio_out & ~mask) | (value & mask);
+  pins_update();
+}
+
+void gpio_set_mask(uint32_t mask)
+{
+  sio_access();
+  sio_out |= mask;
+  pins_update();
+}
+
+void gpio_clr_mask(uint32_t mask)
+{
+  sio_access();
+  sio_out &= ~mask;
+  pins_update();
+}
+
+bool gpio_get(uint gpio)
+{
+  sio_access();
+  return pin_level(gpio);
+}
+
+uint32_t gpio_get_all(void)
+{
+  uint32_t all = 0;
+
+  sio_access();
+  for (uint i = 0; i < N_GPIO; i++) {
+    all |= (uint32_t)pin_level(i) << i;
+  }
+  return all;
+}
+
+bool gpio_get_out_level(uint gpio)
+{
+  sio_access();
+  return (sio_out >> gpio) & 1;
+}
+
+void pio_sm_put(PIO pio, uint sm_, uint32_t data)
+{
+  cpu_access();
+  if (txf.count == FIFO_DEPTH) sim_fatal("write to full TX FIFO");
+  fifo_push(&txf, data, cpu_t);
+  progress_t = cpu_t;
+}
+
+uint32_t pio_sm_get(PIO pio, uint sm_)
+{
+  cpu_access();
+  if (rxf.count == 0) sim_fatal("read from empty RX FIFO");
+  rx_free_t = cpu_t;
+  progress_t = cpu_t;
+  return fifo_pop(&rxf, NULL);
+}
+
+bool pio_sm_is_tx_fifo_full(PIO pio, uint sm_)
+{
+  cpu_access();
+  return txf.count == FIFO_DEPTH;
+}
+
+bool pio_sm_is_tx_fifo_empty(PIO pio, uint sm_)
+{
+  cpu_access();
+  return txf.count == 0;
+}
+
+bool pio_sm_is_rx_fifo_empty(PIO pio, uint sm_)
+{
+  cpu_access();
+  return rxf.count == 0 || rxf.t[rxf.head] > cpu_t;
+}
+
+void pio_sm_exec(PIO pio, uint sm_, uint instr)
+{
+  cpu_access();
+  if ((instr & 0xffe0) == pio_encode_set(pio_pins, 0))
+    pio_pin_put(pins.tms, instr & 1);
+  else
+    sim_fatal("only 'set pins' instruction is modelled");
+}
+
+void pio_sm_set_pins_with_mask(PIO pio, uint sm_, uint32_t pin_values, uint32_t pin_mask)
+{
+  cpu_access();
+  pio_out = (pio_out & ~pin_mask) | (pin_values & pin_mask);
+  pins_update();
+}
+
+void pio_sm_set_clkdiv_int_frac(PIO pio, uint sm_, uint16_t div_int, uint8_t div_frac)
+{
+  pio->sm[sm_].clkdiv = ((uint32_t)div_int << 16) | ((uint32_t)div_frac << 8);
+}
+
+void pio_gpio_init(PIO pio, uint pin)
+{
+  gpio_set_function(pin, GPIO_FUNC_PIO0);
+}
+
+void pio_jtag_init(PIO pio, uint sm_, uint16_t clkdiv, uint pin_tck, uint pin_tdi, uint pin_tdo, uint pin_tms)
+{
+  if (pio != pio0 || sm_ != 0) sim_fatal("only PIO0 SM0 is modelled");
+  pins.tck = pin_tck;
+  pins.tdi = pin_tdi;
+  pins.tdo = pin_tdo;
+  pins.tms = pin_tms;
+  pins.valid = true;
+  pio->sm[sm_].shiftctrl = (8u << PIO_SM0_SHIFTCTRL_PULL_THRESH_LSB) | (8u << PIO_SM0_SHIFTCTRL_PUSH_THRESH_LSB);
+  pio_sm_set_clkdiv_int_frac(pio, sm_, clkdiv, 0);
+  pio_out = 0;
+  tck_level = false;
+  pio_gpio_init(pio, pin_tdi);
+  pio_gpio_init(pio, pin_tms);
+  pio_gpio_init(pio, pin_tck);
+  sm.phase = SM_HEADER;
+  sm.t = cpu_t;
+}
+
+int dma_claim_unused_channel(bool required)
+{
+  for (uint ch = 0; ch < DMA_CHANNELS; ch++) {
+    if (!dma[ch].claimed) {
+      dma[ch].claimed = true;
+      return ch;
+    }
+  }
+  if (required) sim_fatal("no free DMA channels");
+  return -1;
+}
+
+dma_channel_config dma_channel_get_default_config(uint channel)
+{
+  dma_channel_config c = {
+    .size = DMA_SIZE_32,
+    .read_increment = true,
+    .write_increment = false,
+    .bswap = false,
+    .dreq = 0x3f, /* unpaced */
+  };
+  return c;
+}
+
+static void dma_start(uint channel, uint32_t count)
+{
+  cpu_access();
+  dma[channel].count = count;
+  dma[channel].t = dma[channel].done_t = cpu_t;
+  sim_run(cpu_t);
+}
+
+void dma_channel_configure(uint channel, const dma_channel_config *config, volatile void *write_addr,
+                           const volatile void *read_addr, uint transfer_count, bool trigger)
+{
+  dma[channel].c = *config;
+  dma[channel].write_addr = write_addr;
+  dma[channel].read_addr = read_addr;
+  if (trigger) dma_start(channel, transfer_count);
+}
+
+void dma_channel_set_config(uint channel, const dma_channel_config *config, bool trigger)
+{
+  cpu_access();
+  dma[channel].c = *config;
+  if (trigger) sim_fatal("DMA trigger by dma_channel_set_config() is not modelled");
+}
+
+void dma_channel_transfer_to_buffer_now(uint channel, volatile void *write_addr, uint32_t transfer_count)
+{
+  dma[channel].write_addr = write_addr;
+  dma_start(channel, transfer_count);
+}
+
+void dma_channel_transfer_from_buffer_now(uint channel, const volatile void *read_addr, uint32_t transfer_count)
+{
+  dma[channel].read_addr = read_addr;
+  dma_start(channel, transfer_count);
+}
+
+bool dma_channel_is_busy(uint channel)
+{
+  cpu_access();
+  return dma[channel].count != 0 || dma[channel].done_t > cpu_t;
+}
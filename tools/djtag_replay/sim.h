@@ -0,0 +1,54 @@
+/*
+ * Raspberry Pi RP2040 Control firmware for GMM-7550 module
+ * https://www.gmm7550.dev/doc/rp2040.html
+ *
+ * Copyright (c) 2026 Anton Kuzmin <ak@gmm7550.dev>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* RP2040 model for the host build of the DirtyJTAG engine
+ *
+ * Time is counted in clk_sys cycles.  CPU time advances by a fixed
+ * cost on every modelled register access (FIFO status, FIFO read and
+ * write, DMA status), by busy waits, and to the next tick boundary
+ * on vTaskDelay().  PIO state machine runs djtag_tdo program (see
+ * djtag/jtag.pio) on its own time line: 4-entry TX and RX FIFOs, 4 PIO
+ * cycles per TCK period, stalls on empty TX or full RX FIFO.  DMA
+ * channels paced by the PIO DREQs move data as soon as the FIFOs allow.
+ *
+ * A single TAP is connected to the JTAG pins: IR of ir_len bits
+ * (captures ...01), IDCODE selected after Test-Logic-Reset (and by
+ * idcode_ir instruction, if set), any other instruction selects BYPASS.
+ */
+
+#ifndef _SIM_H
+#define _SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct sim_params {
+  uint32_t clk_sys_hz;
+  uint32_t access_cycles; /* CPU cycles per register access */
+  uint32_t idcode;        /* 0 -- TAP has no IDCODE register */
+  uint32_t ir_len;
+  int32_t idcode_ir;      /* -1 -- only after Test-Logic-Reset */
+} sim_params_t;
+
+typedef struct sim_stat {
+  uint64_t tck_cycles;    /* clk_sys cycles with TCK running (PIO shifting) */
+  uint64_t tck_bits;      /* TCK pulses by the PIO */
+  uint64_t sio_edges;     /* rising TCK edges driven by SIO */
+  uint64_t pio_stalls;    /* state machine waited for TX data or RX space */
+  uint64_t task_delays;   /* vTaskDelay() calls */
+} sim_stat_t;
+
+void sim_init(const sim_params_t *params);
+
+/* CPU time, clk_sys cycles */
+uint64_t sim_now(void);
+
+const sim_stat_t *sim_stat(void);
+
+#endif
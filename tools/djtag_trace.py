@@ -0,0 +1,142 @@
+#!/usr/bin/env python3
+#
+# This file is a part of the GMM-7550/RP2040 Control library
+# <https://github.com/gmm-7550/gmm7550-control-rp2040.git>
+#
+# SPDX-License-Identifier: MIT
+#
+# Copyright (c) 2026 Anton Kuzmin <ak@gmm7550.dev>
+
+'''Convert DirtyJTAG command trace ('trace' CLI command, firmware built
+with GMM7550_DJTAG_TRACE=ON) to Chrome trace JSON format, to be viewed
+in Perfetto UI or chrome://tracing.  The trace is read from the CLI
+port, or from a file with the captured 'trace' output.
+'''
+
+__version__ = '0.1.0'
+
+import sys
+import json
+import argparse
+import logging
+from serial import Serial
+
+SERIAL_CLI_DEFAULT_PORT = "/dev/ttyACM1"
+
+COMMANDS = {
+    0x00: 'STOP', 0x01: 'INFO', 0x02: 'FREQ', 0x03: 'XFER',
+    0x04: 'SETSIG', 0x05: 'GETSIG', 0x06: 'CLK', 0x07: 'SETVOLTAGE',
+    0x08: 'GOTOBOOTLOADER', 0x09: 'XFER_LONG', 0x0a: 'TAP_GOTO',
+    0x0b: 'TAP_SHIFT', 0x0c: 'TAP_RUN', 0x0d: 'EDGES',
+}
+TRACE_OP_DATA = 0xff
+
+logging.basicConfig(stream=sys.stderr, level=logging.WARNING)
+log = logging.getLogger('djtag_trace')
+
+def read_port(port):
+    lines = []
+    with Serial(port, timeout=1) as cli:
+        cli.reset_input_buffer()
+        cli.write(b'trace\r')
+        count = None
+        while count is None or len(lines) < count:
+            l = cli.readline().decode('ascii', errors='replace')
+            if not l:
+                break
+            l = l.strip()
+            if l.startswith('# DirtyJTAG trace'):
+                count = int(l.split()[3])
+            elif count is not None and l and not l.startswith('#'):
+                lines.append(l)
+    return lines
+
+def parse(lines):
+    entries = []
+    for l in lines:
+        f = l.split()
+        if len(f) != 6 or l.startswith('#'):
+            continue
+        try:
+            op = int(f[0], 16)
+            bits, buf, t0, t1, t2 = (int(x) for x in f[1:])
+        except ValueError:
+            continue
+        entries.append((op, bits, buf, t0, t1, t2))
+    return entries
+
+def op_name(op):
+    if op == TRACE_OP_DATA:
+        return 'XFER_LONG data'
+    return COMMANDS.get(op & 0x0f, 'CMD_%02x' % op)
+
+def to_chrome(entries):
+    events = []
+    if not entries:
+        return {'traceEvents': events}
+    base = entries[0][3]
+    def ts(t):
+        # time_us_32() wraps around every ~71 minutes
+        return (t - base) & 0xffffffff
+    for op, bits, buf, t0, t1, t2 in entries:
+        args = {'opcode': '0x%02x' % op, 'bits': bits, 'buffer': buf}
+        events.append({'name': op_name(op), 'ph': 'X', 'pid': 1, 'tid': 1,
+                       'ts': ts(t0), 'dur': ts(t1) - ts(t0), 'args': args})
+        if t2:
+            events.append({'name': 'reply', 'ph': 'X', 'pid': 1, 'tid': 2,
+                           'ts': ts(t1), 'dur': ts(t2) - ts(t1), 'args': args})
+    events.append({'name': 'thread_name', 'ph': 'M', 'pid': 1, 'tid': 1,
+                   'args': {'name': 'command execution'}})
+    events.append({'name': 'thread_name', 'ph': 'M', 'pid': 1, 'tid': 2,
+                   'args': {'name': 'until reply sent'}})
+    return {'traceEvents': events}
+
+def main():
+    p = argparse.ArgumentParser(description = __doc__)
+
+    p.add_argument('-V', '--version', action='version', version=__version__)
+
+    p.add_argument('-v', '--verbose', action='count', default=0, help='be more verbose')
+
+    p.add_argument('-P', '--port', type=str,
+                   help='read trace from the CLI port (e.g. '+SERIAL_CLI_DEFAULT_PORT+')')
+
+    p.add_argument('-o', '--output', type=str, default='-',
+                   help='output JSON file (default: stdout)')
+
+    p.add_argument('file', nargs='?', help='captured trace output')
+
+    args = p.parse_args()
+
+    if args.verbose == 0:
+        log.setLevel(logging.WARNING)
+    elif args.verbose == 1:
+        log.setLevel(logging.INFO)
+    else: # >= 2
+        log.setLevel(logging.DEBUG)
+
+    if args.port:
+        lines = read_port(args.port)
+    elif args.file:
+        with open(args.file) as f:
+            lines = f.readlines()
+    else:
+        lines = sys.stdin.readlines()
+
+    entries = parse(lines)
+    log.info('%d trace entries', len(entries))
+    if entries:
+        span = (entries[-1][4] - entries[0][3]) & 0xffffffff
+        bits = sum(e[1] for e in entries)
+        log.info('%d bits in %d us', bits, span)
+
+    trace = to_chrome(entries)
+    if args.output == '-':
+        json.dump(trace, sys.stdout)
+    else:
+        with open(args.output, 'w') as f:
+            json.dump(trace, f)
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(main())
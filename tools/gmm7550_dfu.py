@@ -0,0 +1,98 @@
+#!/usr/bin/env python3
+#
+# This file is a part of the GMM-7550/RP2040 Control library
+# <https://github.com/gmm-7550/gmm7550-control-rp2040.git>
+#
+# SPDX-License-Identifier: MIT
+#
+# Copyright (c) 2026 Anton Kuzmin <ak@gmm7550.dev>
+
+'''Make DFU image of the RP2040 firmware (src/dfu.c): the firmware binary
+(gmm_control.bin) is followed by a trailer with its length and CRC-32,
+checked by the firmware before the update, and by the standard DFU
+suffix (checked by dfu-util).  Optionally download it to the board(s)
+with dfu-util.
+'''
+
+__version__ = '0.1.0'
+
+import sys
+import struct
+import zlib
+import argparse
+import logging
+import subprocess
+
+USB_VID = 0x1209
+USB_PID = 0xC0CA
+
+DFU_TRAILER_MAGIC = 0x55464d47
+DFU_STAGE_SIZE = 1024 * 1024 # upper half of the flash
+
+logging.basicConfig(stream=sys.stderr, level=logging.WARNING)
+log = logging.getLogger('gmm7550_dfu')
+
+def dfu_image(fw):
+    '''Firmware with GMM-7550 trailer and DFU suffix'''
+    img = fw + struct.pack('<IIII', DFU_TRAILER_MAGIC, len(fw), zlib.crc32(fw), 0)
+    # bcdDevice (any), idProduct, idVendor, bcdDFU, 'UFD', suffix length
+    img += struct.pack('<HHHH3sB', 0xffff, USB_PID, USB_VID, 0x0100, b'UFD', 16)
+    # DFU suffix CRC has no final inversion
+    return img + struct.pack('<I', zlib.crc32(img) ^ 0xffffffff)
+
+def main():
+    p = argparse.ArgumentParser(description = __doc__)
+
+    p.add_argument('-V', '--version', action='version', version=__version__)
+
+    p.add_argument('-v', '--verbose', action='count', default=0, help='be more verbose')
+
+    p.add_argument('-o', '--output', type=str, default=None,
+                   help='DFU image file (default: input with .dfu extension)')
+
+    p.add_argument('-D', '--download', action='store_true',
+                   help='download the image with dfu-util')
+
+    p.add_argument('-s', '--serial', type=str, action='append', default=[],
+                   help='serial number of the board to update (may be repeated, default: the only one)')
+
+    p.add_argument('file', help='firmware binary (gmm_control.bin)')
+
+    args = p.parse_args()
+
+    if args.verbose == 0:
+        log.setLevel(logging.WARNING)
+    elif args.verbose == 1:
+        log.setLevel(logging.INFO)
+    else: # >= 2
+        log.setLevel(logging.DEBUG)
+
+    with open(args.file, 'rb') as f:
+        fw = f.read()
+    if len(fw) + 16 > DFU_STAGE_SIZE:
+        log.error('%s: %d bytes, does not fit into the staging area', args.file, len(fw))
+        return 1
+
+    out = args.output
+    if out is None:
+        out = (args.file[:-4] if args.file.endswith('.bin') else args.file) + '.dfu'
+    with open(out, 'wb') as f:
+        f.write(dfu_image(fw))
+    log.info('%s: %d bytes, CRC-32 %08x', out, len(fw), zlib.crc32(fw))
+
+    if not args.download:
+        return 0
+    rc = 0
+    for sn in args.serial or [None]:
+        cmd = ['dfu-util', '-d', '%04x:%04x' % (USB_VID, USB_PID), '-a', '0', '-D', out]
+        if sn:
+            cmd += ['-S', sn]
+        log.info(' '.join(cmd))
+        r = subprocess.run(cmd, stdout=None if args.verbose else subprocess.DEVNULL)
+        if r.returncode:
+            log.error('%s: dfu-util failed (%d)', sn or 'board', r.returncode)
+            rc = 1
+    return rc
+
+if __name__ == '__main__':
+    sys.exit(main())
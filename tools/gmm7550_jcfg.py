@@ -0,0 +1,85 @@
+#!/usr/bin/env python3
+#
+# This file is a part of the GMM-7550/RP2040 Control library
+# <https://github.com/gmm-7550/gmm7550-control-rp2040.git>
+#
+# SPDX-License-Identifier: MIT
+#
+# Copyright (c) 2026 Anton Kuzmin <ak@gmm7550.dev>
+
+'''Command line tool to configure GateMate FPGA via JTAG on the RP2040
+USB adapter board.  The bitstream is streamed over the JTAG CDC channel,
+JTAG instructions are issued by the firmware.  Configuration mode
+should be set to JTAG via CLI interface beforehand:
+> cfg c
+'''
+
+__version__ = '0.1.0'
+
+import sys
+import struct
+import argparse
+import logging
+from serial import Serial
+
+SERIAL_JTAG_BLOCK_SIZE = 4096
+SERIAL_JTAG_DEFAULT_PORT = "/dev/ttyACM3"
+
+JCFG_SOH = b'\x01'
+
+logging.basicConfig(stream=sys.stderr, level=logging.WARNING)
+log = logging.getLogger('gmm7550_jcfg')
+
+def load_bitstream(fname, port):
+    with open(fname, mode='br') as f:
+        data = f.read()
+
+    with Serial(port) as jtag:
+        jtag.reset_input_buffer()
+        jtag.write(JCFG_SOH + struct.pack('<I', len(data)))
+        for start in range(0, len(data), SERIAL_JTAG_BLOCK_SIZE):
+            jtag.write(data[start:start + SERIAL_JTAG_BLOCK_SIZE])
+        jtag.flush()
+        return jtag.readline().decode('ascii').split()
+
+def main():
+    p = argparse.ArgumentParser(description = __doc__,
+                                formatter_class=argparse.RawDescriptionHelpFormatter)
+
+    p.add_argument('-V', '--version', action='version', version=__version__)
+
+    p.add_argument('-v', '--verbose', action='count', default=0, help='be more verbose')
+
+    p.add_argument('-P', '--port', type=str,
+                   default=SERIAL_JTAG_DEFAULT_PORT,
+                   help='Serial-to-JTAG device (default: '+SERIAL_JTAG_DEFAULT_PORT+')')
+
+    p.add_argument('file', help='bitstream file (.bit)')
+
+    args = p.parse_args()
+
+    if args.verbose == 0:
+        log.setLevel(logging.WARNING)
+    elif args.verbose == 1:
+        log.setLevel(logging.INFO)
+    else: # >= 2
+        log.setLevel(logging.DEBUG)
+
+    log.info('Load bitstream: %s', args.file)
+    result = load_bitstream(args.file, args.port)
+
+    if len(result) != 2:
+        log.error('Unexpected reply from the firmware: %s' % ' '.join(result))
+        return 2
+
+    if result[0] == 'PASS':
+        log.info('%s bytes loaded, configuration done' % result[1])
+        return 0
+    elif result[0] == 'FAIL':
+        log.error('Configuration failed (%s bytes loaded)' % result[1])
+    else:
+        log.error('Cannot load bitstream, check configuration mode (cfg c)')
+    return 1
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -10,10 +10,11 @@
 '''Command line tool to configure FPGA and program NOR Flash on the
 GMM-7550 module via SPI on the RP2040 USB adapter board.  Note that SPI
 multiplexer and FPGA configuration mode should be set to the correct
-values via CLI interface.
+values via CLI interface, or with -A option (USB vendor requests, requires
+pyusb).
 '''
 
-__version__ = '0.7.2'
+__version__ = '0.8.0'
 
 import os
 import sys
@@ -31,9 +32,40 @@ SERIAL_SPI_SLOW_BIT_RATE    = 15
 logging.basicConfig(stream=sys.stderr, level=logging.WARNING)
 log = logging.getLogger('gmm7550_spi')
 
+######################################################################
+# SPI Mux and Configuration Mode via USB vendor requests
+######################################################################
+
+USB_VID = 0x1209
+USB_PID = 0xC0CA
+
+VREQ_MUX = 0x34
+VREQ_CFG = 0x35
+VREQ_ERRORS = {
+    1: 'bad argument',
+    2: 'unsafe SPI Mux and Configuration Mode combination',
+    3: 'module is off or in hard reset',
+}
+
+def board_request(req, arg):
+    import usb.core
+    dev = usb.core.find(idVendor=USB_VID, idProduct=USB_PID)
+    if dev is None:
+        raise IOError('USB adapter %04x:%04x not found' % (USB_VID, USB_PID))
+    status, state, port1, _ = dev.ctrl_transfer(0xc0, req, arg, 0, 4)
+    if status:
+        raise IOError(VREQ_ERRORS.get(status, 'error %d' % status))
+    log.debug('SPI Mux/Configuration Mode: 0x%02x' % port1)
+
+def set_spi_mode(cfg, mux):
+    # Configuration Mode first: SPI Active mode with FPGA SPI Mux is unsafe
+    if cfg is not None:
+        board_request(VREQ_CFG, cfg)
+    board_request(VREQ_MUX, mux)
+
 ######################################################################
 # Load FPGA Configuration via SPI interface
-# GMM-7550 Settings:
+# GMM-7550 Settings (or -A option):
 # > cfg 4
 # > mux 1
 ######################################################################
@@ -271,6 +303,10 @@ def main():
                    choices=['east', 'west', 'north'],
                    help='Access SPI NOR on the Memory add-on board')
 
+    p.add_argument('-A', '--auto-mode',
+                   action='store_true',
+                   help='Set SPI Mux and Configuration Mode via USB (FPGA SPI for configuration and Memory board, NOR FLASH otherwise)')
+
     p.add_argument('-P', '--port', type=str,
                    default=SERIAL_SPI_DEFAULT_PORT,
                    help='Serial-to-SPI device (default: '+SERIAL_SPI_DEFAULT_PORT+')')
@@ -305,6 +341,14 @@ def main():
         log.error('FPGA configure and SPI NOR read and write operations require file to be specified')
         return 1
 
+    if args.auto_mode and not args.no_hardware:
+        if args.configure or args.spi_mem:
+            log.info('SPI Passive configuration mode, FPGA SPI')
+            set_spi_mode(4, 1)
+        else:
+            log.info('SPI NOR FLASH')
+            set_spi_mode(None, 2)
+
     # FPGA configuration with explicit command and configuration file
 
     if args.configure:
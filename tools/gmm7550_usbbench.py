@@ -0,0 +1,147 @@
+#!/usr/bin/env python3
+#
+# This file is a part of the GMM-7550/RP2040 Control library
+# <https://github.com/gmm-7550/gmm7550-control-rp2040.git>
+#
+# SPDX-License-Identifier: MIT
+#
+# Copyright (c) 2026 Anton Kuzmin <ak@gmm7550.dev>
+
+'''USB link benchmark of the RP2040 adapter board: DirtyJTAG interface
+is switched to sink, source or echo mode (firmware built with
+GMM7550_USB_BENCH=ON), data are moved for a given time, and the host
+side throughput is printed together with the on-device byte counts and
+timings.  Requires pyusb.
+'''
+
+__version__ = '0.1.0'
+
+import sys
+import time
+import struct
+import argparse
+import logging
+import usb.core
+import usb.util
+
+USB_VID = 0x1209
+USB_PID = 0xC0CA
+
+DJTAG_ITF = 0
+DJTAG_EP_OUT = 0x01
+DJTAG_EP_IN = 0x82
+
+VREQ_BENCH = 0x21
+MODES = {'off': 0, 'echo': 1, 'source': 2, 'sink': 3}
+
+logging.basicConfig(stream=sys.stderr, level=logging.WARNING)
+log = logging.getLogger('gmm7550_usbbench')
+
+def set_mode(dev, mode):
+    dev.ctrl_transfer(0x40, VREQ_BENCH, MODES[mode], 0, None)
+
+def get_stat(dev):
+    '''Returns dict with on-device counters'''
+    data = bytes(dev.ctrl_transfer(0xc0, VREQ_BENCH, 0, 0, 28))
+    mode, out_b, out_x, in_b, in_x, t_first, t_last = struct.unpack('<7I', data)
+    return {'mode': mode, 'out_bytes': out_b, 'out_xfers': out_x,
+            'in_bytes': in_b, 'in_xfers': in_x, 'us': t_last - t_first}
+
+def drain(dev):
+    '''Read out whatever the source mode left in the IN endpoint'''
+    n = 0
+    while True:
+        try:
+            n += len(dev.read(DJTAG_EP_IN, 4096, timeout=100))
+        except usb.core.USBTimeoutError:
+            return n
+
+def bench_sink(dev, duration, size):
+    buf = bytes(size)
+    n = 0
+    t0 = time.perf_counter()
+    while time.perf_counter() - t0 < duration:
+        n += dev.write(DJTAG_EP_OUT, buf, timeout=1000)
+    return n, time.perf_counter() - t0
+
+def bench_source(dev, duration, size):
+    n = 0
+    t0 = time.perf_counter()
+    while time.perf_counter() - t0 < duration:
+        data = dev.read(DJTAG_EP_IN, size, timeout=1000)
+        n += len(data)
+    return n, time.perf_counter() - t0
+
+def bench_echo(dev, duration, size):
+    pattern = bytes(i & 0xff for i in range(size))
+    n = 0
+    t0 = time.perf_counter()
+    while time.perf_counter() - t0 < duration:
+        dev.write(DJTAG_EP_OUT, pattern, timeout=1000)
+        data = bytes()
+        while len(data) < size:
+            data += bytes(dev.read(DJTAG_EP_IN, size, timeout=1000))
+        if data != pattern:
+            raise ValueError('echo data mismatch after %d bytes' % n)
+        n += size
+    return n, time.perf_counter() - t0
+
+BENCH = {'sink': bench_sink, 'source': bench_source, 'echo': bench_echo}
+
+def main():
+    p = argparse.ArgumentParser(description = __doc__)
+
+    p.add_argument('-V', '--version', action='version', version=__version__)
+
+    p.add_argument('-v', '--verbose', action='count', default=0, help='be more verbose')
+
+    p.add_argument('-t', '--time', type=float, default=5.0,
+                   help='duration of every test, seconds (default: 5)')
+
+    p.add_argument('-s', '--size', type=int, default=None,
+                   help='transfer size, bytes (default: 16384, 512 for echo -- DirtyJTAG queue depth)')
+
+    p.add_argument('mode', nargs='*',
+                   help='tests to run: sink, source, echo (default: all)')
+
+    args = p.parse_args()
+
+    if args.verbose == 0:
+        log.setLevel(logging.WARNING)
+    elif args.verbose == 1:
+        log.setLevel(logging.INFO)
+    else: # >= 2
+        log.setLevel(logging.DEBUG)
+
+    for mode in args.mode:
+        if mode not in BENCH:
+            p.error('unknown test: %s' % mode)
+
+    dev = usb.core.find(idVendor=USB_VID, idProduct=USB_PID)
+    if dev is None:
+        log.error('USB adapter %04x:%04x not found', USB_VID, USB_PID)
+        return 1
+    usb.util.claim_interface(dev, DJTAG_ITF)
+
+    for mode in args.mode or ['sink', 'source', 'echo']:
+        size = args.size or (512 if mode == 'echo' else 16384)
+        set_mode(dev, mode)
+        try:
+            n, t = BENCH[mode](dev, args.time, size)
+            s = get_stat(dev)
+        finally:
+            set_mode(dev, 'off')
+            if mode == 'source':
+                log.info('%d bytes drained', drain(dev))
+        print('%-6s host: %d bytes in %.3f s, %.1f kB/s' % (mode, n, t, n / t / 1000))
+        dt = s['us']
+        print('       device: OUT %d bytes/%d xfers, IN %d bytes/%d xfers in %.3f s%s' %
+              (s['out_bytes'], s['out_xfers'], s['in_bytes'], s['in_xfers'], dt / 1e6,
+               ', %.1f/%.1f kB/s' % (s['out_bytes'] * 1000 / dt, s['in_bytes'] * 1000 / dt)
+               if dt else ''))
+
+    usb.util.release_interface(dev, DJTAG_ITF)
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,145 @@
+#!/usr/bin/env python3
+#
+# This file is a part of the GMM-7550/RP2040 Control library
+# <https://github.com/gmm-7550/gmm7550-control-rp2040.git>
+#
+# SPDX-License-Identifier: MIT
+#
+# Copyright (c) 2026 Anton Kuzmin <ak@gmm7550.dev>
+
+'''Read USB traffic counters of the RP2040 adapter board (vendor control
+request, see src/usbstat.c) and print per interface byte and packet
+rates, short packets, stalls and buffer-full (back-pressure) events
+over the sampling interval.  Also shows and switches the USB buffer
+profile (src/profile.c).  Requires pyusb.
+'''
+
+__version__ = '0.2.0'
+
+import sys
+import time
+import struct
+import argparse
+import logging
+import usb.core
+
+USB_VID = 0x1209
+USB_PID = 0xC0CA
+
+VREQ_USBSTAT = 0x20
+USBSTAT_MAX_LEN = 512
+
+VREQ_PROFILE = 0x22
+PROFILES = ('default', 'jtag', 'spi', 'console') # firmware order
+
+COUNTERS = ('bytes', 'packets', 'short', 'stalls', 'full')
+
+logging.basicConfig(stream=sys.stderr, level=logging.WARNING)
+log = logging.getLogger('gmm7550_usbstat')
+
+def read_stat(dev, reset=False):
+    '''Returns (time_us, bus_resets, {name: (out_counters, in_counters)})'''
+    data = bytes(dev.ctrl_transfer(0xc0, VREQ_USBSTAT, 1 if reset else 0, 0,
+                                   USBSTAT_MAX_LEN))
+    version, n, nc = struct.unpack('<BBBx', data[:4])
+    if version != 1:
+        raise ValueError('unknown usbstat reply version %d' % version)
+    t, resets = struct.unpack('<II', data[4:12])
+    chans = {}
+    p = 12
+    for _ in range(n):
+        name = data[p:p + 8].rstrip(b'\0').decode('ascii')
+        p += 8
+        out = struct.unpack('<%dI' % nc, data[p:p + 4 * nc])
+        p += 4 * nc
+        inp = struct.unpack('<%dI' % nc, data[p:p + 4 * nc])
+        p += 4 * nc
+        chans[name] = (out, inp)
+    return t, resets, chans
+
+def profile(dev, name=None):
+    '''Returns active profile name, switches (the board reboots) if name is given'''
+    w = PROFILES.index(name) + 1 if name else 0
+    status, active, n, _ = bytes(dev.ctrl_transfer(0xc0, VREQ_PROFILE, w, 0, 4))
+    if status:
+        raise ValueError('profile %s is rejected by the board' % name)
+    return PROFILES[active] if active < len(PROFILES) else str(active)
+
+def report(s0, s1):
+    t0, _, c0 = s0
+    t1, resets, c1 = s1
+    dt = ((t1 - t0) & 0xffffffff) / 1e6
+    print('%.3f s, %d bus reset(s) since counters reset' % (t1 / 1e6, resets))
+    print('%-8s %-3s %12s %9s %9s %6s %6s %10s %8s' %
+          ('channel', 'dir', 'bytes', 'packets', 'short', 'stalls', 'full', 'B/s', 'pkt/s'))
+    for name, dirs in c1.items():
+        for d, label in enumerate(('OUT', 'IN')):
+            now = dirs[d]
+            was = c0[name][d] if name in c0 else (0,) * len(now)
+            delta = [(a - b) & 0xffffffff for a, b in zip(now, was)]
+            if not any(delta):
+                continue
+            print('%-8s %-3s %12d %9d %9d %6d %6d %10.0f %8.0f' %
+                  (name, label, delta[0], delta[1], delta[2], delta[3], delta[4],
+                   delta[0] / dt if dt else 0, delta[1] / dt if dt else 0))
+
+def main():
+    p = argparse.ArgumentParser(description = __doc__)
+
+    p.add_argument('-V', '--version', action='version', version=__version__)
+
+    p.add_argument('-v', '--verbose', action='count', default=0, help='be more verbose')
+
+    p.add_argument('-i', '--interval', type=float, default=1.0,
+                   help='sampling interval, seconds (default: 1)')
+
+    p.add_argument('-n', '--count', type=int, default=1,
+                   help='number of reports, 0 -- until interrupted (default: 1)')
+
+    p.add_argument('-r', '--reset', action='store_true',
+                   help='reset the counters')
+
+    p.add_argument('-p', '--profile', choices=PROFILES,
+                   help='switch USB buffer profile (the board reboots)')
+
+    args = p.parse_args()
+
+    if args.verbose == 0:
+        log.setLevel(logging.WARNING)
+    elif args.verbose == 1:
+        log.setLevel(logging.INFO)
+    else: # >= 2
+        log.setLevel(logging.DEBUG)
+
+    dev = usb.core.find(idVendor=USB_VID, idProduct=USB_PID)
+    if dev is None:
+        log.error('USB adapter %04x:%04x not found', USB_VID, USB_PID)
+        return 1
+
+    if args.profile:
+        log.info('profile %s -> %s', profile(dev), args.profile)
+        profile(dev, args.profile)
+        return 0
+
+    log.info('USB buffer profile: %s', profile(dev))
+
+    if args.reset:
+        read_stat(dev, reset=True)
+        log.info('counters reset')
+        return 0
+
+    s0 = read_stat(dev)
+    n = 0
+    try:
+        while args.count == 0 or n < args.count:
+            time.sleep(args.interval)
+            s1 = read_stat(dev)
+            report(s0, s1)
+            s0 = s1
+            n += 1
+    except KeyboardInterrupt:
+        pass
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,110 @@
+#!/usr/bin/env python3
+#
+# This file is a part of the GMM-7550/RP2040 Control library
+# <https://github.com/gmm-7550/gmm7550-control-rp2040.git>
+#
+# SPDX-License-Identifier: MIT
+#
+# Copyright (c) 2026 Anton Kuzmin <ak@gmm7550.dev>
+
+'''Xilinx Virtual Cable (XVC) bridge for the RP2040 USB adapter board.
+Accepts XVC clients on a TCP port and passes the protocol as is to the
+XVC CDC channel, where the commands are executed by the firmware.
+One client is served at a time.
+'''
+
+__version__ = '0.1.0'
+
+import sys
+import socket
+import argparse
+import logging
+import threading
+from serial import Serial
+
+SERIAL_XVC_DEFAULT_PORT = "/dev/ttyACM4"
+XVC_DEFAULT_ADDRESS = "127.0.0.1"
+XVC_DEFAULT_TCP_PORT = 2542
+
+XVC_BLOCK_SIZE = 4096
+
+logging.basicConfig(stream=sys.stderr, level=logging.WARNING)
+log = logging.getLogger('gmm7550_xvc')
+
+def tty_to_socket(tty, conn, done):
+    while not done.is_set():
+        data = tty.read(tty.in_waiting or 1)
+        if data:
+            try:
+                conn.sendall(data)
+            except OSError:
+                break
+
+def serve_client(tty, conn):
+    done = threading.Event()
+    tty.reset_input_buffer()
+    rx = threading.Thread(target=tty_to_socket, args=(tty, conn, done), daemon=True)
+    rx.start()
+    try:
+        while True:
+            data = conn.recv(XVC_BLOCK_SIZE)
+            if not data:
+                break
+            tty.write(data)
+    except OSError as e:
+        log.warning('Connection error: %s', e)
+    finally:
+        done.set()
+        rx.join()
+
+def run_bridge(port, address, tcp_port):
+    with Serial(port, timeout=0.1) as tty, \
+         socket.socket(socket.AF_INET, socket.SOCK_STREAM) as srv:
+        srv.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        srv.bind((address, tcp_port))
+        srv.listen(1)
+        log.info('Listening on %s:%d', address, tcp_port)
+        while True:
+            conn, peer = srv.accept()
+            with conn:
+                conn.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+                log.info('Client connected: %s:%d', *peer)
+                serve_client(tty, conn)
+                log.info('Client disconnected')
+
+def main():
+    p = argparse.ArgumentParser(description = __doc__)
+
+    p.add_argument('-V', '--version', action='version', version=__version__)
+
+    p.add_argument('-v', '--verbose', action='count', default=0, help='be more verbose')
+
+    p.add_argument('-P', '--port', type=str,
+                   default=SERIAL_XVC_DEFAULT_PORT,
+                   help='Serial-to-XVC device (default: '+SERIAL_XVC_DEFAULT_PORT+')')
+
+    p.add_argument('-a', '--address', type=str,
+                   default=XVC_DEFAULT_ADDRESS,
+                   help='address to listen on (default: '+XVC_DEFAULT_ADDRESS+')')
+
+    p.add_argument('-p', '--tcp-port', type=int,
+                   default=XVC_DEFAULT_TCP_PORT,
+                   help='TCP port (default: %d)' % XVC_DEFAULT_TCP_PORT)
+
+    args = p.parse_args()
+
+    if args.verbose == 0:
+        log.setLevel(logging.WARNING)
+    elif args.verbose == 1:
+        log.setLevel(logging.INFO)
+    else: # >= 2
+        log.setLevel(logging.DEBUG)
+
+    try:
+        run_bridge(args.port, args.address, args.tcp_port)
+    except KeyboardInterrupt:
+        pass
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(main())